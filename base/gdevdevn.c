@@ -31,6 +31,7 @@
 #include "gdevp14.h"
 #include "gdevdevnprn.h"
 #include "gxdevsop.h"
+#include "gxsync.h"
 
 /*
  * Utility routines for common DeviceN related parameters:
@@ -133,6 +134,222 @@ void build_cmyk_map(gx_device *pdev, int num_comp,
     }
 }
 
+/*
+ * The separation writer (see gdevdevn.h). As with the downscaler's pipe,
+ * the rows go round a ring of slots: the caller fills a slot and signals
+ * each thread, and each thread signals back once it has written its
+ * separations from that slot.
+ */
+#define DEVN_SEP_WRITER_DEPTH 8
+#define DEVN_SEP_WRITER_MAX_THREADS 16
+
+typedef struct devn_sep_writer_slot_s {
+    int   y;
+    bool  quit;                 /* Tells the threads to exit */
+    byte *data[GS_CLIENT_COLOR_MAX_COMPONENTS];
+    byte *row[GS_CLIENT_COLOR_MAX_COMPONENTS];  /* data, or NULL */
+    int   code[DEVN_SEP_WRITER_MAX_THREADS];    /* Per thread */
+} devn_sep_writer_slot_t;
+
+typedef struct devn_sep_writer_thread_s {
+    devn_sep_writer_t *writer;
+    int                index;
+    gx_semaphore_t    *work;    /* Signalled once per slot queued */
+    gx_semaphore_t    *done;    /* Signalled once per slot written */
+    gp_thread_id       thread;
+} devn_sep_writer_thread_t;
+
+struct devn_sep_writer_s {
+    gs_memory_t             *memory;
+    int                      num_comps;
+    size_t                   row_size;
+    int                      num_threads;
+    devn_sep_write_row_proc *write_row;
+    void                    *arg;
+    devn_sep_writer_thread_t thread[DEVN_SEP_WRITER_MAX_THREADS];
+    int                      queued;    /* Rows handed over */
+    int                      taken;     /* Rows known to be written */
+    int                      code;
+    byte                    *data_alloc;
+    devn_sep_writer_slot_t   slot[DEVN_SEP_WRITER_DEPTH];
+};
+
+static void
+devn_sep_writer_thread(void *arg)
+{
+    devn_sep_writer_thread_t *thread = (devn_sep_writer_thread_t *)arg;
+    devn_sep_writer_t        *writer = thread->writer;
+    int                       n, comp, code = 0;
+
+    for (n = 0; ; n = (n+1) % DEVN_SEP_WRITER_DEPTH) {
+        devn_sep_writer_slot_t *slot = &writer->slot[n];
+
+        gx_semaphore_wait(thread->work);
+        if (slot->quit)
+            break;
+        /* After an error, keep taking the rows, but don't write them. */
+        for (comp = thread->index; comp < writer->num_comps && code >= 0;
+             comp += writer->num_threads)
+            code = writer->write_row(writer->arg, comp, slot->row[comp], slot->y);
+        slot->code[thread->index] = code;
+        gx_semaphore_signal(thread->done);
+    }
+}
+
+/* Wait for the oldest row handed over to be written. */
+static void
+devn_sep_writer_wait(devn_sep_writer_t *writer)
+{
+    devn_sep_writer_slot_t *slot = &writer->slot[writer->taken % DEVN_SEP_WRITER_DEPTH];
+    int i;
+
+    for (i = 0; i < writer->num_threads; i++) {
+        gx_semaphore_wait(writer->thread[i].done);
+        if (slot->code[i] < 0 && writer->code >= 0)
+            writer->code = slot->code[i];
+    }
+    writer->taken++;
+}
+
+static void
+devn_sep_writer_free(devn_sep_writer_t *writer)
+{
+    gs_memory_t *mem = writer->memory;
+    int          i;
+
+    for (i = 0; i < DEVN_SEP_WRITER_MAX_THREADS; i++) {
+        if (writer->thread[i].work)
+            gx_semaphore_free(writer->thread[i].work);
+        if (writer->thread[i].done)
+            gx_semaphore_free(writer->thread[i].done);
+    }
+    gs_free_object(mem, writer->data_alloc, "devn_sep_writer(data)");
+    gs_free_object(mem, writer, "devn_sep_writer");
+}
+
+/* Tell the (first n) threads to exit, and wait for them. All the slots
+ * must have been written. */
+static void
+devn_sep_writer_quit(devn_sep_writer_t *writer, int n)
+{
+    int i;
+
+    writer->slot[writer->queued % DEVN_SEP_WRITER_DEPTH].quit = true;
+    for (i = 0; i < n; i++)
+        gx_semaphore_signal(writer->thread[i].work);
+    for (i = 0; i < n; i++)
+        gp_thread_finish(writer->thread[i].thread);
+}
+
+devn_sep_writer_t *
+devn_sep_writer_start(gs_memory_t *mem, int num_comps, size_t row_size,
+                      int num_threads, devn_sep_write_row_proc *write_row,
+                      void *arg)
+{
+    devn_sep_writer_t *writer;
+    size_t             span = (row_size + 31) & ~(size_t)31;
+    byte              *data;
+    int                i, j;
+
+    if (num_comps <= 0 || num_comps > GS_CLIENT_COLOR_MAX_COMPONENTS)
+        return NULL;
+    if (num_threads > num_comps)
+        num_threads = num_comps;
+    if (num_threads > DEVN_SEP_WRITER_MAX_THREADS)
+        num_threads = DEVN_SEP_WRITER_MAX_THREADS;
+    if (num_threads <= 0)
+        return NULL;
+
+    writer = (devn_sep_writer_t *)gs_alloc_bytes(mem, sizeof(*writer),
+                                                 "devn_sep_writer");
+    if (writer == NULL)
+        return NULL;
+    memset(writer, 0, sizeof(*writer));
+    writer->memory = mem;
+    writer->num_comps = num_comps;
+    writer->row_size = row_size;
+    writer->write_row = write_row;
+    writer->arg = arg;
+    writer->data_alloc = gs_alloc_bytes(mem, span * num_comps * DEVN_SEP_WRITER_DEPTH + 32,
+                                        "devn_sep_writer(data)");
+    if (writer->data_alloc == NULL) {
+        devn_sep_writer_free(writer);
+        return NULL;
+    }
+    data = writer->data_alloc + ((32-(intptr_t)writer->data_alloc) & 31);
+    for (i = 0; i < DEVN_SEP_WRITER_DEPTH; i++)
+        for (j = 0; j < num_comps; j++, data += span)
+            writer->slot[i].data[j] = data;
+
+    for (i = 0; i < num_threads; i++) {
+        devn_sep_writer_thread_t *thread = &writer->thread[i];
+
+        thread->writer = writer;
+        thread->index = i;
+        thread->work = gx_semaphore_label(gx_semaphore_alloc(mem), "devn_sep_writer work");
+        thread->done = gx_semaphore_label(gx_semaphore_alloc(mem), "devn_sep_writer done");
+        if (thread->work == NULL || thread->done == NULL)
+            break;
+    }
+    if (i < num_threads) {
+        devn_sep_writer_free(writer);
+        return NULL;
+    }
+    writer->num_threads = num_threads;
+    for (i = 0; i < num_threads; i++) {
+        if (gp_thread_start(devn_sep_writer_thread, &writer->thread[i],
+                            &writer->thread[i].thread) < 0)
+            break;
+        gp_thread_label(writer->thread[i].thread, "Separation writer");
+    }
+    if (i < num_threads) {
+        devn_sep_writer_quit(writer, i);
+        devn_sep_writer_free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+int
+devn_sep_writer_put(devn_sep_writer_t *writer, int y, byte **src)
+{
+    devn_sep_writer_slot_t *slot;
+    int                     i;
+
+    if (writer->queued - writer->taken == DEVN_SEP_WRITER_DEPTH)
+        devn_sep_writer_wait(writer);
+    if (writer->code < 0)
+        return writer->code;
+
+    slot = &writer->slot[writer->queued % DEVN_SEP_WRITER_DEPTH];
+    slot->y = y;
+    for (i = 0; i < writer->num_comps; i++) {
+        if (src[i] == NULL)
+            slot->row[i] = NULL;
+        else {
+            memcpy(slot->data[i], src[i], writer->row_size);
+            slot->row[i] = slot->data[i];
+        }
+    }
+    writer->queued++;
+    for (i = 0; i < writer->num_threads; i++)
+        gx_semaphore_signal(writer->thread[i].work);
+    return 0;
+}
+
+int
+devn_sep_writer_finish(devn_sep_writer_t *writer)
+{
+    int code;
+
+    while (writer->taken < writer->queued)
+        devn_sep_writer_wait(writer);
+    devn_sep_writer_quit(writer, writer->num_threads);
+    code = writer->code;
+    devn_sep_writer_free(writer);
+    return code;
+}
+
 /*
  * This utility routine calculates the number of bits required to store
  * color information.  In general the values are rounded up to an even
@@ -448,4 +448,30 @@ void build_cmyk_map(gx_device *pdev, int num_comp,
         equivalent_cmyk_color_params *equiv_cmyk_colors,
         cmyk_composite_map * cmyk_map);
 
+/*
+ * Writing the separations of a page on several threads. The caller gets
+ * each row of the page once (from the downscaler) and hands the rows of
+ * all the separations over with devn_sep_writer_put; each separation is
+ * then converted, compressed and written by one of the writer's threads,
+ * separation comp going to thread comp % num_threads, so each separation
+ * sees its rows in order. The row passed to write_row belongs to that
+ * call, and may be changed in place. src entries may be NULL, in which
+ * case write_row gets NULL too.
+ */
+typedef int (devn_sep_write_row_proc)(void *arg, int comp, byte *row, int y);
+
+typedef struct devn_sep_writer_s devn_sep_writer_t;
+
+/* Returns NULL if the threads couldn't be started, in which case the
+ * caller should write the separations itself. */
+devn_sep_writer_t *devn_sep_writer_start(gs_memory_t *mem, int num_comps,
+                          size_t row_size, int num_threads,
+                          devn_sep_write_row_proc *write_row, void *arg);
+
+/* Returns the first error from write_row, if there has been one. */
+int devn_sep_writer_put(devn_sep_writer_t *writer, int y, byte **src);
+
+/* Waits for all the rows to be written and frees the writer. */
+int devn_sep_writer_finish(devn_sep_writer_t *writer);
+
 #endif		/* ifndef gdevdevn_INCLUDED */
@@ -71,6 +71,8 @@
 #include "assert_.h"
 #include "gxgetbit.h"
 #include "gdevkrnlsclass.h"
+#include "gstrace.h"
+#include "gsmemrep.h"
 
 #if RAW_DUMP
 unsigned int global_index = 0;
@@ -151,10 +153,10 @@ typedef struct pdf14_abuf_state_s {
 } pdf14_abuf_state_t;
 
 /* Buffer stack	data structure */
-gs_private_st_ptrs7(st_pdf14_buf, pdf14_buf, "pdf14_buf",
+gs_private_st_ptrs8(st_pdf14_buf, pdf14_buf, "pdf14_buf",
                     pdf14_buf_enum_ptrs, pdf14_buf_reloc_ptrs,
                     saved, data, backdrop, transfer_fn, mask_stack,
-                    matte, group_color_info);
+                    matte, group_color_info, tile_dirty);
 
 gs_private_st_ptrs3(st_pdf14_ctx, pdf14_ctx, "pdf14_ctx",
                     pdf14_ctx_enum_ptrs, pdf14_ctx_reloc_ptrs,
@@ -1015,6 +1017,8 @@ template_transform_color_buffer(gs_gstate *pgs, pdf14_ctx *ctx, gx_device *dev,
         gs_free_object(ctx->memory, output->data,
             "pdf14_transform_color_buffer");
         output->data = des_data;
+        gs_memreport_pdf14(ctx->memory, (int64_t)(des_planestride * des_n_planes) - output->data_size);
+        output->data_size = des_planestride * des_n_planes;
         /* Note, this is needed for case where we did a put image, as the
            resulting transformed buffer may not be a full page. */
         output->rect.p.x = x0;
@@ -1142,6 +1146,13 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
     result->page_group = false;
     result->group_color_info = NULL;
     result->group_popped = false;
+    result->tile_dirty = NULL;
+    result->tile_x0 = rect->p.x >> PDF14_TILE_SHIFT;
+    result->tile_y0 = rect->p.y >> PDF14_TILE_SHIFT;
+    result->tile_cols = 0;
+    result->tile_rows = 0;
+    result->tile_raster = 0;
+    result->data_size = 0;
 
     if (idle || height <= 0) {
         /* Empty clipping - will skip all drawings. */
@@ -1157,6 +1168,8 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
             gs_free_object(memory, result, "pdf14_buf_new");
             return NULL;
         }
+        result->data_size = planestride * n_planes;
+        gs_memreport_pdf14(memory, result->data_size);
         if (has_alpha_g) {
             int alpha_g_plane = n_chan + (has_shape ? 1 : 0);
             /* Memsetting by 0, so this copes with the deep case too */
@@ -1168,6 +1181,27 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
             memset (result->data + tags_plane * planestride,
                     GS_UNTOUCHED_TAG, planestride);
         }
+        /* Only bother with a tile map if there is more than one tile. */
+        result->tile_cols = ((rect->q.x - 1) >> PDF14_TILE_SHIFT) -
+                            result->tile_x0 + 1;
+        result->tile_rows = ((rect->q.y - 1) >> PDF14_TILE_SHIFT) -
+                            result->tile_y0 + 1;
+        if (result->tile_cols > 1 || result->tile_rows > 1) {
+            size_t tile_size;
+
+            result->tile_raster = (result->tile_cols + 7) >> 3;
+            tile_size = (size_t)result->tile_raster * result->tile_rows;
+
+            result->tile_dirty = gs_alloc_bytes(memory, tile_size,
+                                                "pdf14_buf_new(tile_dirty)");
+            if (result->tile_dirty == NULL) {
+                gs_memreport_pdf14(memory, -(int64_t)result->data_size);
+                gs_free_object(memory, result->data, "pdf14_buf_new");
+                gs_free_object(memory, result, "pdf14_buf_new");
+                return NULL;
+            }
+            memset(result->tile_dirty, 0, tile_size);
+        }
     }
     /* Initialize dirty box with an invalid rectangle (the reversed rectangle).
      * Any future drawing will make it valid again, so we won't blend back
@@ -1190,7 +1224,9 @@ pdf14_buf_free(pdf14_buf *buf)
 
     gs_free_object(memory, buf->transfer_fn, "pdf14_buf_free");
     gs_free_object(memory, buf->matte, "pdf14_buf_free");
+    gs_memreport_pdf14(memory, -(int64_t)buf->data_size);
     gs_free_object(memory, buf->data, "pdf14_buf_free");
+    gs_free_object(memory, buf->tile_dirty, "pdf14_buf_free");
 
     while (group_color_info) {
        if (group_color_info->icc_profile != NULL) {
@@ -1551,6 +1587,58 @@ pdf14_push_transparency_group(pdf14_ctx	*ctx, gs_int_rect *rect, bool isolated,
     return 0;
 }
 
+/*
+ * Compose tos onto nos, restricted to the tiles of tos that have actually
+ * been marked. Untouched areas of tos have zero alpha, so composing them
+ * is a no-op, except when nos is a knockout group, where the backdrop
+ * has to be restored; in that case compose the whole rectangle.
+ */
+static void
+pdf14_compose_group_tiles(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
+              int x0, int x1, int y0, int y1, int n_chan, bool additive,
+              const pdf14_nonseparable_blending_procs_t * pblend_procs,
+              bool has_matte, bool overprint, gx_color_index drawn_comps,
+              gs_memory_t *memory, gx_device *dev)
+{
+    int tx0, tx1, ty0, ty1, tx, ty, run;
+    int ry0, ry1;
+
+    if (tos->tile_dirty == NULL || nos->knockout) {
+        pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, n_chan,
+                            additive, pblend_procs, has_matte, overprint,
+                            drawn_comps, memory, dev);
+        return;
+    }
+    tx0 = (x0 >> PDF14_TILE_SHIFT) - tos->tile_x0;
+    tx1 = ((x1 - 1) >> PDF14_TILE_SHIFT) - tos->tile_x0 + 1;
+    ty0 = (y0 >> PDF14_TILE_SHIFT) - tos->tile_y0;
+    ty1 = ((y1 - 1) >> PDF14_TILE_SHIFT) - tos->tile_y0 + 1;
+    if (tx0 < 0 || ty0 < 0 || tx1 > tos->tile_cols || ty1 > tos->tile_rows) {
+        /* Should not happen as x0..y1 lie within tos->dirty. */
+        pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, n_chan,
+                            additive, pblend_procs, has_matte, overprint,
+                            drawn_comps, memory, dev);
+        return;
+    }
+    for (ty = ty0; ty < ty1; ty++) {
+        ry0 = max(y0, (ty + tos->tile_y0) << PDF14_TILE_SHIFT);
+        ry1 = min(y1, (ty + tos->tile_y0 + 1) << PDF14_TILE_SHIFT);
+        for (tx = tx0; tx < tx1; tx += run) {
+            run = 1;
+            if (!PDF14_TILE_MARKED(tos, tx, ty))
+                continue;
+            /* Compose runs of adjacent marked tiles in one go. */
+            while (tx + run < tx1 && PDF14_TILE_MARKED(tos, tx + run, ty))
+                run++;
+            pdf14_compose_group(tos, nos, maskbuf,
+                                max(x0, (tx + tos->tile_x0) << PDF14_TILE_SHIFT),
+                                min(x1, (tx + run + tos->tile_x0) << PDF14_TILE_SHIFT),
+                                ry0, ry1, n_chan, additive, pblend_procs,
+                                has_matte, overprint, drawn_comps, memory, dev);
+        }
+    }
+}
+
 static	int
 pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     const pdf14_nonseparable_blending_procs_t * pblend_procs,
@@ -1567,6 +1655,7 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     bool overprint = pdev->overprint;
     gx_color_index drawn_comps = pdev->drawn_comps_stroke | pdev->drawn_comps_fill;
     bool has_matte = false;
+    int64_t start = gs_trace_begin(ctx->memory);
     int code = 0;
 
 #ifdef DEBUG
@@ -1727,7 +1816,7 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
                             ctx->stack->deep);
 #endif
              /* compose. never do overprint in this case */
-            pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
+            pdf14_compose_group_tiles(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
                  nos->group_color_info->isadditive,
                  nos->group_color_info->blend_procs,
                  has_matte, false, drawn_comps, ctx->memory, dev);
@@ -1735,7 +1824,7 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     } else {
         /* Group color spaces are the same.  No color conversions needed */
         if (x0 < x1 && y0 < y1)
-            pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
+            pdf14_compose_group_tiles(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
                                 ctx->additive, pblend_procs, has_matte, overprint,
                                 drawn_comps, ctx->memory, dev);
     }
@@ -1751,6 +1840,7 @@ exit:
     }
     if_debug1m('v', ctx->memory, "[v]pop buf, idle=%d\n", tos->idle);
     pdf14_buf_free(tos);
+    gs_trace_end(ctx->memory, start, "pdf14", "compose", -1);
     if (code < 0)
         return_error(code);
     return 0;
@@ -2041,6 +2131,8 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
         /* Free the old object, NULL test was above */
         gs_free_object(ctx->memory, tos->data, "pdf14_pop_transparency_mask");
         tos->data = new_data_buf;
+        gs_memreport_pdf14(ctx->memory, (int64_t)tos->planestride - tos->data_size);
+        tos->data_size = tos->planestride;
         /* Data is single channel now */
         tos->n_chan = 1;
         tos->n_planes = 1;
@@ -4795,10 +4887,7 @@ do_pdf14_copy_alpha_color(gx_device * dev, const byte * data, int data_x,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
 
     /* composite with backdrop only. */
     line = buf->data + (x - buf->rect.p.x) + (y - buf->rect.p.y) * rowstride;
@@ -4995,10 +5084,7 @@ do_pdf14_copy_alpha_color_16(gx_device * dev, const byte * data, int data_x,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
 
     /* composite with backdrop only. */
     line = buf->data + (x - buf->rect.p.x)*2 + (y - buf->rect.p.y) * rowstride;
@@ -6993,6 +7079,8 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
     fake_tos.dirty.p.y = y;
     fake_tos.dirty.q.x = x + w;
     fake_tos.dirty.q.y = y + h;
+    fake_tos.tile_dirty = NULL;
+    fake_tos.data_size = 0;
     fake_tos.has_alpha_g = 0;
     fake_tos.has_shape = 0;
     fake_tos.has_tags = device_encodes_tags(dev);
@@ -8157,10 +8245,7 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
 
     /* composite with backdrop only. */
     if (has_backdrop)
@@ -8379,10 +8464,7 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
 
 
     /* composite with backdrop only. */
@@ -126,6 +126,18 @@ struct pdf14_group_color_s {
 
 typedef struct pdf14_ctx_s pdf14_ctx;
 
+/* Marks made into a buffer are tracked on a coarse grid of square tiles
+   (in addition to the overall dirty bbox) so that composing a group
+   back onto its parent can skip the parts of the bbox that were never
+   drawn to. Tiles are aligned to device space, so the maps of two
+   buffers line up. */
+#define PDF14_TILE_SHIFT 6
+
+/* Test the bit for tile (tx, ty), relative to tile_x0/tile_y0 */
+#define PDF14_TILE_MARKED(buf, tx, ty)\
+    ((buf)->tile_dirty[(ty) * (buf)->tile_raster + ((tx) >> 3)] &\
+     (0x80 >> ((tx) & 7)))
+
 struct pdf14_buf_s {
     pdf14_buf *saved;
     byte *backdrop;  /* This is needed for proper non-isolated knockout support */
@@ -160,6 +172,13 @@ struct pdf14_buf_s {
     int matte_num_comps;
     uint16_t *matte;
     gs_int_rect dirty;
+    byte *tile_dirty; /* One bit per tile, NULL if not tracked */
+    int tile_x0;      /* Tile coordinates of the top left tile */
+    int tile_y0;
+    int tile_cols;
+    int tile_rows;
+    int tile_raster;  /* Bytes per row of tile_dirty */
+    size_t data_size; /* bytes allocated for data, for the memory report */
     pdf14_mask_t *mask_stack;
     bool idle;
 
@@ -29,6 +29,7 @@
 #include "gstrans.h"
 #include "gxdownscale.h"
 #include "gsbitops.h"
+#include "gstrace.h"
 
 #include "gdevkrnlsclass.h" /* 'standard' built in subclasses, currently First/Last Page and obejct filter */
 
@@ -109,51 +110,163 @@ gdev_prn_open(gx_device * pdev)
     return code;
 }
 
-/* This is called various places to wait for any pending bg print thread and */
-/* perform its cleanup                                                       */
+/* Wait for one background printing thread and perform its cleanup.          */
 static void
-prn_finish_bg_print(gx_device_printer *ppdev)
+prn_finish_bg_print_page(gx_device_printer *ppdev, bg_print_t *bg_print)
 {
     /* if we have a a bg printing device that was created, then wait for its	*/
     /* semaphore (it may already have been signalled, but that's OK.) then	*/
     /* close and unlink the files and free the device and its private allocator	*/
-    if (ppdev->bg_print && (ppdev->bg_print->device != NULL)) {
+    if (bg_print->device != NULL) {
         int closecode;
-        gx_device_printer *bgppdev = (gx_device_printer *)ppdev->bg_print->device;
-
-        gx_semaphore_wait(ppdev->bg_print->sema);
-        /* If numcopies > 1, then the bg_print->device will have closed and reopened
-         * the output file, so the pointer in the original device is now stale,
-         * so copy it back.
-         * If numcopies == 1, this is pointless, but benign.
-         */
-        ppdev->file = bgppdev->file;
-        closecode = gdev_prn_close_printer((gx_device *)ppdev);
-        if (ppdev->bg_print->return_code == 0)
-            ppdev->bg_print->return_code = closecode;	/* return code here iff there wasn't another error */
-        teardown_device_and_mem_for_thread(ppdev->bg_print->device,
-                                           ppdev->bg_print->thread_id, true);
-        ppdev->bg_print->device = NULL;
-        if (ppdev->bg_print->ocfile) {
-            closecode = ppdev->bg_print->oio_procs->fclose(ppdev->bg_print->ocfile, ppdev->bg_print->ocfname, true);
-            if (ppdev->bg_print->return_code == 0)
-               ppdev->bg_print->return_code = closecode;
+        gx_device_printer *bgppdev = (gx_device_printer *)bg_print->device;
+
+        gx_semaphore_wait(bg_print->sema);
+        if (bg_print->detached) {
+            /* The output file belongs to this page only, the foreground may */
+            /* already have opened the file for a later page.                */
+            gp_file *save_file = ppdev->file;
+
+            ppdev->file = bgppdev->file;
+            closecode = gdev_prn_close_printer((gx_device *)ppdev);
+            ppdev->file = save_file;
+            bg_print->detached = false;
+        } else {
+            /* If numcopies > 1, then the bg_print->device will have closed and reopened
+             * the output file, so the pointer in the original device is now stale,
+             * so copy it back.
+             * If numcopies == 1, this is pointless, but benign.
+             */
+            ppdev->file = bgppdev->file;
+            closecode = gdev_prn_close_printer((gx_device *)ppdev);
+        }
+        if (bg_print->return_code == 0)
+            bg_print->return_code = closecode;	/* return code here iff there wasn't another error */
+        teardown_device_and_mem_for_thread(bg_print->device,
+                                           bg_print->thread_id, true);
+        bg_print->device = NULL;
+        if (bg_print->ocfile) {
+            closecode = bg_print->oio_procs->fclose(bg_print->ocfile, bg_print->ocfname, true);
+            if (bg_print->return_code == 0)
+               bg_print->return_code = closecode;
         }
-        if (ppdev->bg_print->ocfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->ocfname, "prn_finish_bg_print(ocfname)");
+        if (bg_print->ocfname) {
+            gs_free_object(ppdev->memory->non_gc_memory, bg_print->ocfname, "prn_finish_bg_print(ocfname)");
         }
-        if (ppdev->bg_print->obfile) {
-            closecode = ppdev->bg_print->oio_procs->fclose(ppdev->bg_print->obfile, ppdev->bg_print->obfname, true);
-            if (ppdev->bg_print->return_code == 0)
-               ppdev->bg_print->return_code = closecode;
+        if (bg_print->obfile) {
+            closecode = bg_print->oio_procs->fclose(bg_print->obfile, bg_print->obfname, true);
+            if (bg_print->return_code == 0)
+               bg_print->return_code = closecode;
         }
-        if (ppdev->bg_print->obfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->obfname, "prn_finish_bg_print(obfname)");
+        if (bg_print->obfname) {
+            gs_free_object(ppdev->memory->non_gc_memory, bg_print->obfname, "prn_finish_bg_print(obfname)");
         }
-        ppdev->bg_print->ocfile = ppdev->bg_print->obfile =
-          ppdev->bg_print->ocfname = ppdev->bg_print->obfname = NULL;
+        bg_print->ocfile = bg_print->obfile =
+          bg_print->ocfname = bg_print->obfname = NULL;
+        bg_print->mem_used = 0;
     }
 }
+
+/* Finish the oldest page in flight. Pages other than the newest one (which */
+/* is the ppdev->bg_print that is kept for re-use) are freed, returning any */
+/* error from that page. Returns 1 if there was nothing left to finish.     */
+static int
+prn_finish_oldest_bg_print(gx_device_printer *ppdev)
+{
+    bg_print_t **pprev = &ppdev->bg_print;
+    bg_print_t *oldest;
+    int code;
+
+    if (ppdev->bg_print == NULL)
+        return 1;
+    while ((*pprev)->next != NULL)
+        pprev = &(*pprev)->next;
+    oldest = *pprev;
+    if (oldest == ppdev->bg_print) {
+        if (oldest->device == NULL)
+            return 1;
+        prn_finish_bg_print_page(ppdev, oldest);
+        return oldest->return_code;
+    }
+    prn_finish_bg_print_page(ppdev, oldest);
+    code = oldest->return_code;
+    *pprev = NULL;
+    if (oldest->sema != NULL)
+        gx_semaphore_free(oldest->sema);
+    gs_free_object(ppdev->memory->non_gc_memory, oldest, "prn_finish_oldest_bg_print");
+    return code;
+}
+
+/* This is called various places to wait for any pending bg print threads and */
+/* perform their cleanup. Pages are finished in the order they were started.  */
+static void
+prn_finish_bg_print(gx_device_printer *ppdev)
+{
+    int code, ecode = 0;
+
+    if (ppdev->bg_print == NULL)
+        return;
+    while (ppdev->bg_print->next != NULL) {
+        code = prn_finish_oldest_bg_print(ppdev);
+        if (code < 0 && ecode == 0)
+            ecode = code;
+    }
+    prn_finish_bg_print_page(ppdev, ppdev->bg_print);
+    /* Report errors from the older pages with the same (sticky) return code */
+    if (ppdev->bg_print->return_code == 0)
+        ppdev->bg_print->return_code = ecode;
+}
+
+/* Pages can be left rendering in the background while several later pages */
+/* are interpreted only when each page goes to its own output file, and the */
+/* page doesn't need to be complete when output_page returns.               */
+static bool
+prn_bg_print_pipelined(gx_device_printer *ppdev, int num_copies)
+{
+    gs_parsed_file_name_t parsed;
+    const char *fmt = NULL;
+
+    if (ppdev->bg_print_pages < 2 || !ppdev->bg_print_requested ||
+        ppdev->saved_pages_list != NULL || num_copies != 1)
+        return false;
+    return gx_parse_output_file_name(&parsed, &fmt, ppdev->fname,
+                                     strlen(ppdev->fname), ppdev->memory) >= 0 &&
+           fmt != NULL;
+}
+
+/* Finish the oldest pages in flight until one more page of 'needed' bytes */
+/* fits within both the BGPrintPages and the BGPrintMemory limits.         */
+static int
+prn_bg_print_make_room(gx_device_printer *ppdev, size_t needed)
+{
+    int ecode = 0;
+
+    for (;;) {
+        bg_print_t *bg;
+        int in_flight = 0;
+        size_t used = 0;
+        int code;
+
+        for (bg = ppdev->bg_print; bg != NULL; bg = bg->next) {
+            if (bg->device != NULL) {
+                in_flight++;
+                used += bg->mem_used;
+            }
+        }
+        if (in_flight == 0 ||
+            (in_flight < ppdev->bg_print_pages &&
+             (ppdev->bg_print_memory == 0 ||
+              used + needed <= ppdev->bg_print_memory)))
+            break;
+        code = prn_finish_oldest_bg_print(ppdev);
+        if (code == 1)
+            break;
+        if (code < 0 && ecode == 0)
+            ecode = code;
+    }
+    return ecode;
+}
+
 /* Generic closing for the printer device. */
 /* Specific devices may wish to extend this. */
 int
@@ -590,6 +703,12 @@ gdev_prn_get_param(gx_device *dev, char *Param, void *list)
     if (strcmp(Param, "BGPrint") == 0) {
         return param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested);
     }
+    if (strcmp(Param, "BGPrintPages") == 0) {
+        return param_write_int(plist, "BGPrintPages", &ppdev->bg_print_pages);
+    }
+    if (strcmp(Param, "BGPrintMemory") == 0) {
+        return param_write_size_t(plist, "BGPrintMemory", &ppdev->bg_print_memory);
+    }
     if (strcmp(Param, "ReopenPerPage") == 0) {
         return param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage);
     }
@@ -657,6 +776,8 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
         (code = param_write_int(plist, "NumRenderingThreads", &ppdev->num_render_threads_requested)) < 0 ||
         (code = param_write_bool(plist, "OpenOutputFile", &ppdev->OpenOutputFile)) < 0 ||
         (code = param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested)) < 0 ||
+        (code = param_write_int(plist, "BGPrintPages", &ppdev->bg_print_pages)) < 0 ||
+        (code = param_write_size_t(plist, "BGPrintMemory", &ppdev->bg_print_memory)) < 0 ||
         (code = param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage)) < 0 ||
         (code = param_write_bool(plist, "pageneutralcolor", &pageneutralcolor)) < 0
         )
@@ -720,6 +841,8 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     int width = pdev->width;
     int height = pdev->height;
     int nthreads = ppdev->num_render_threads_requested;
+    int bg_print_pages = ppdev->bg_print_pages;
+    size_t bg_print_memory = ppdev->bg_print_memory;
     gdev_space_params save_sp;
     gs_param_string ofs;
     gs_param_string bls;
@@ -839,6 +962,26 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
             break;
     }
 
+    switch (code = param_read_int(plist, (param_name = "BGPrintPages"), &bg_print_pages)) {
+        case 0:
+            if (bg_print_pages >= 0)
+                break;
+            code = gs_note_error(gs_error_rangecheck);
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 1:
+            ;
+    }
+    switch (code = param_read_size_t(plist, (param_name = "BGPrintMemory"), &bg_print_memory)) {
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 0:
+        case 1:
+            break;
+    }
+
     switch (code = param_read_string(plist, (param_name = "saved-pages"),
                                                         &saved_pages)) {
         default:
@@ -882,6 +1025,8 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
         ppdev->Duplex_set = duplex_set;
     }
     ppdev->num_render_threads_requested = nthreads;
+    ppdev->bg_print_pages = bg_print_pages;
+    ppdev->bg_print_memory = bg_print_memory;
     if (bls.data != 0) {
         ppdev->BLS_force_memory = (bls.data[0] == 'm');
     }
@@ -950,8 +1095,11 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
     gs_devn_params *pdevn_params;
     int outcode = 0, errcode = 0, endcode, closecode = 0;
     int code;
+    int64_t start;
+    bool pipelined = bg_print_ok && prn_bg_print_pipelined(ppdev, num_copies);
 
-    prn_finish_bg_print(ppdev);		/* finish any previous background printing */
+    if (!pipelined)
+        prn_finish_bg_print(ppdev);	/* finish any previous background printing */
 
     if (pdev->width < 1 || pdev->height < 1 || pdev->HWResolution[0] <= 0 || pdev->HWResolution[1] <= 0)
         return_error(gs_error_configurationerror);
@@ -973,6 +1121,39 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 (ppdev->bg_print_requested || ppdev->num_render_threads_requested > 0)) {
                 threads_enabled = clist_enable_multi_thread_render(pdev);
             }
+            if (pipelined && ppdev->bg_print) {
+                /* Wait for enough of the older pages to leave room for this one, */
+                /* then start this page with a new bg_print if the newest one is  */
+                /* still busy.                                                    */
+                gx_device_clist_common *cdev = (gx_device_clist_common *)ppdev;
+                size_t needed = ppdev->buffer_space *
+                                    (1 + max(ppdev->num_render_threads_requested, 0));
+
+                if (cdev->page_info.cfile != NULL)
+                    needed += cdev->page_info.io_procs->ftell(cdev->page_info.cfile);
+                if (cdev->page_info.bfile != NULL)
+                    needed += cdev->page_info.io_procs->ftell(cdev->page_info.bfile);
+                code = prn_bg_print_make_room(ppdev, needed);
+                if (code < 0) {
+                    prn_finish_bg_print(ppdev);
+                    outcode = code;
+                    threads_enabled = 0;
+                } else if (ppdev->bg_print->device != NULL) {
+                    bg_print_t *bg_print = (bg_print_t *)gs_alloc_bytes(ppdev->memory->non_gc_memory,
+                                                sizeof(bg_print_t), "gdev_prn_output_page_aux(bg_print)");
+
+                    if (bg_print == NULL) {
+                        /* Not fatal, just stop overlapping more than one page */
+                        prn_finish_bg_print(ppdev);
+                    } else {
+                        memset(bg_print, 0, sizeof(bg_print_t));
+                        bg_print->next = ppdev->bg_print;
+                        ppdev->bg_print = bg_print;
+                    }
+                }
+                if (ppdev->bg_print->device == NULL)
+                    ppdev->bg_print->mem_used = needed;
+            }
             /* NB: we leave the semaphore allocated until foreground printing or close */
             /* If there was an error, abort on this page -- no good way to handle this */
             /* but it means that the error will be reported AFTER another page was     */
@@ -1044,6 +1225,13 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 gp_thread_label(ppdev->bg_print->thread_id, "BG print thread");
                 /* Page was succesfully started in bg_print mode */
                 print_foreground = 0;
+                if (pipelined) {
+                    /* The thread owns the output file of this page now, so the  */
+                    /* next page opens its own file rather than waiting for this */
+                    /* one in prn_finish_bg_print.                               */
+                    ppdev->bg_print->detached = true;
+                    ppdev->file = NULL;
+                }
                 /* Now we need to set up the next page so it will use new clist files */
                 if ((code = clist_open(pdev)) < 0) 	/* this should do it */
                     /* OOPS! can't proceed with the next page */
@@ -1067,9 +1255,11 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 }
                 /* Here's where we actually let the device's print_page_copies work */
                 /* Print the accumulated page description. */
+                start = gs_trace_begin(pdev->memory);
                 outcode = (*ppdev->printer_procs.print_page_copies)(ppdev, ppdev->file,
                                                           num_copies);
                 gp_fflush(ppdev->file);
+                gs_trace_end(pdev->memory, start, "output", "print_page", pdev->PageCount + 1);
                 errcode = (gp_ferror(ppdev->file) ? gs_note_error(gs_error_ioerror) : 0);
                 /* NB: background printing does this differently in its thread */
                 closecode = gdev_prn_close_printer(pdev);
@@ -1180,10 +1370,12 @@ prn_print_page_in_background(void *data)
     int code, errcode = 0;
     int num_copies = bg_print->num_copies;
     gx_device_printer *ppdev = (gx_device_printer *)bg_print->device;
+    int64_t start = gs_trace_begin(ppdev->memory);
 
     code = (*ppdev->printer_procs.print_page_copies)(ppdev, ppdev->file,
                                                           num_copies);
     gp_fflush(ppdev->file);
+    gs_trace_end(ppdev->memory, start, "output", "print_page", ppdev->PageCount + 1);
 
     errcode = (gp_ferror(ppdev->file) ? gs_note_error(gs_error_ioerror) : 0);
     bg_print->return_code = code < 0 ? code : errcode;
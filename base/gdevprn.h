@@ -124,6 +124,9 @@ typedef struct bg_print_s {
     char *obfname;	                /* block file name */
     clist_file_ptr obfile;	/* block file, normally 0 */
     const clist_io_procs_t *oio_procs;
+    size_t mem_used;			/* estimated clist + buffer memory of this page */
+    bool detached;			/* output file was handed over to the thread */
+    struct bg_print_s *next;		/* next older page still in flight, or NULL */
 } bg_print_t;
 
 #define gx_prn_device_common\
@@ -143,6 +146,8 @@ typedef struct bg_print_s {
         bool bg_print_requested;	/* request background printing of page from clist */\
         bg_print_t *bg_print;           /* background printing data shared with thread */\
         int num_render_threads_requested;	/* for multiple band rendering threads */\
+        int bg_print_pages;		/* max pages in flight for background printing */\
+        size_t bg_print_memory;		/* memory budget for pages in flight, 0 = none */\
         gx_saved_pages_list *saved_pages_list;	/* list when we are saving pages instead of printing */\
         gx_device_procs save_procs_while_delaying_erasepage	/* save device procs while delaying erasepage. */
 
@@ -222,6 +227,8 @@ prn_dev_proc_get_space_params(gx_default_get_space_params);
         0/*false*/,	/* bg_print_requested */\
         0,              /* *bg_print */\
         0, 		/* num_render_threads_requested */\
+        0, 		/* bg_print_pages */\
+        0, 		/* bg_print_memory */\
         0,              /* saved_pages_list */\
         { 0 }           /* save_procs_while_delaying_erasepage */
 #define prn_device_body_rest_(print_page)\
@@ -344,6 +344,25 @@ int gp_fprintf(gp_file *f, const char *fmt, ...)
 #endif
     ;
 
+/*
+ * Map the first 'size' bytes of a file into memory for reading. Returns
+ * NULL if the file cannot be mapped (or the platform doesn't support it),
+ * in which case the caller should read it with gp_fpread as usual. Data
+ * written with buffered writes must have been flushed first. The mapping
+ * stays valid after the file is closed, until gp_funmap.
+ */
+void *gp_fmap(gp_file *f, gs_offset_t size);
+
+void gp_funmap(void *addr, gs_offset_t size);
+
+/*
+ * Hint that bytes offset to offset + size of a file will be read soon, so
+ * that the OS can start reading them in. 'addr' is the mapping returned by
+ * gp_fmap, or NULL if the file isn't mapped. Does nothing where this isn't
+ * supported.
+ */
+void gp_fwillneed(gp_file *f, void *addr, gs_offset_t offset, gs_offset_t size);
+
 /* ------ Reading from stdin, unbuffered if possible ------ */
 
 /* Read bytes from stdin, using unbuffered if possible.
@@ -639,6 +658,12 @@ int gp_pread_impl(char *buf, size_t count, gs_offset_t offset, FILE *f);
 
 int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f);
 
+void *gp_fmap_impl(FILE *f, gs_offset_t size);
+
+void gp_funmap_impl(void *addr, gs_offset_t size);
+
+void gp_fwillneed_impl(FILE *f, void *addr, gs_offset_t offset, gs_offset_t size);
+
 gs_offset_t gp_ftell_impl(FILE *f);
 
 int gp_fseek_impl(FILE *strm, gs_offset_t offset, int origin);
@@ -121,6 +121,12 @@ gp_thread_finish(gp_thread_id thread)
 {
 }
 
+gp_thread_id
+gp_thread_self(void)
+{
+    return NULL;
+}
+
 /* No threading -> no globals */
 gs_globals *gp_get_globals(void)
 {
@@ -305,6 +305,20 @@ int gp_pwrite_impl(char *buf, size_t count, gs_offset_t offset, FILE *f)
     return -1;
 }
 
+/* Mapping files isn't supported; callers fall back to gp_fpread */
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+    return NULL;
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+}
+
+void gp_fwillneed_impl(FILE *f, void *addr, gs_offset_t offset, gs_offset_t size)
+{
+}
+
 /* -------------- Helpers for gp_file_name_combine_generic ------------- */
 
 uint gp_file_name_root(const char *fname, uint len)
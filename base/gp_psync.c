@@ -473,6 +473,11 @@ void gp_thread_finish(gp_thread_id thread)
     pthread_join((pthread_t)thread, NULL);
 }
 
+gp_thread_id gp_thread_self(void)
+{
+    return (gp_thread_id)pthread_self();
+}
+
 void (gp_monitor_label)(gp_monitor * mona, const char *name)
 {
     pthread_mutex_t * const mon = &((gp_pthread_recursive_t *)mona)->mutex;
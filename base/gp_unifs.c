@@ -32,6 +32,10 @@
 #include "dirent_.h"
 #include "unistd_.h"
 #include <stdlib.h>             /* for mkstemp/mktemp */
+#if defined(HAVE_MMAP) && HAVE_MMAP == 1 && !defined(GS_NO_FILESYSTEM)
+#include <sys/mman.h>
+#include "fcntl_.h"
+#endif
 
 #if !defined(HAVE_FSEEKO)
 #define ftello ftell
@@ -245,6 +249,44 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
 #endif
 }
 
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+#if defined(HAVE_MMAP) && HAVE_MMAP == 1 && !defined(GS_NO_FILESYSTEM)
+    void *addr;
+
+    if ((uint64_t)size > (size_t)-1)
+        return NULL;    /* Too big for the address space */
+    addr = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fileno(f), 0);
+    return addr == MAP_FAILED ? NULL : addr;
+#else
+    return NULL;
+#endif
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+#if defined(HAVE_MMAP) && HAVE_MMAP == 1 && !defined(GS_NO_FILESYSTEM)
+    munmap(addr, (size_t)size);
+#endif
+}
+
+void gp_fwillneed_impl(FILE *f, void *addr, gs_offset_t offset, gs_offset_t size)
+{
+#if defined(HAVE_MMAP) && HAVE_MMAP == 1 && !defined(GS_NO_FILESYSTEM)
+    if (addr != NULL) {
+        /* madvise wants a page aligned start */
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        gs_offset_t start = offset & ~(gs_offset_t)(page - 1);
+
+        (void)madvise((byte *)addr + start, (size_t)(offset + size - start), MADV_WILLNEED);
+        return;
+    }
+#  ifdef POSIX_FADV_WILLNEED
+    (void)posix_fadvise(fileno(f), offset, size, POSIX_FADV_WILLNEED);
+#  endif
+#endif
+}
+
 /* Set a file into binary or text mode. */
 int
 gp_setmode_binary_impl(FILE * pfile, bool mode) /* lgtm [cpp/useless-expression] */
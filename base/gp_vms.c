@@ -311,6 +311,20 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
     return -1;
 }
 
+/* Mapping files isn't supported; callers fall back to gp_fpread */
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+    return NULL;
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+}
+
+void gp_fwillneed_impl(FILE *f, void *addr, gs_offset_t offset, gs_offset_t size)
+{
+}
+
 /* Set a file into binary or text mode. */
 int
 gp_setmode_binary_impl(FILE * pfile, bool binary)
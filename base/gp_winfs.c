@@ -157,6 +157,20 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
     return ret;
 }
 
+/* Mapping files isn't supported; callers fall back to gp_fpread */
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+    return NULL;
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+}
+
+void gp_fwillneed_impl(FILE *f, void *addr, gs_offset_t offset, gs_offset_t size)
+{
+}
+
 /* --------- 64 bit file access ----------- */
 /* MSVC versions before 8 doen't provide big files.
    MSVC 8 doesn't distinguish big and small files,
@@ -438,3 +438,8 @@ void gp_thread_finish(gp_thread_id thread)
     CloseHandle((HANDLE)thread);
 #endif
 }
+
+gp_thread_id gp_thread_self(void)
+{
+    return (gp_thread_id)(size_t)GetCurrentThreadId();
+}
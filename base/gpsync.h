@@ -127,6 +127,13 @@ int gp_thread_start(gp_thread_creation_callback_t fun, void *arg, gp_thread_id *
  */
 void gp_thread_finish(gp_thread_id thread);
 
+/*
+ * Return a value identifying the calling thread. This is only for comparing
+ * with other values returned by gp_thread_self (for instance to tell threads
+ * apart in diagnostic output), it must not be passed to gp_thread_finish.
+ */
+gp_thread_id gp_thread_self(void);
+
 void gp_thread_label(gp_thread_id thread, const char *name);
 #ifndef BOBBIN
 #define gp_thread_label(A,B) do {} while(0)
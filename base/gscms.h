@@ -450,7 +450,7 @@ struct gsicc_link_s {
     gscms_procs_t procs;
     gsicc_hashlink_t hashcode;
     struct gsicc_link_cache_s *icc_link_cache;
-    int ref_count;	/* All accesses to ref_count are protected by the link cache lock once the link is cached! */
+    int ref_count;	/* All accesses to ref_count are protected by the lock of the link cache shard once the link is cached! */
     int validity;	/* 1 once link is completely built and usable, 0 while building, -1 if failed to build. */
     gsicc_link_t *next;
     gx_monitor_t *lock;		/* lock used while changing contents (link cache lock can never be taken while holding this) */
@@ -467,14 +467,27 @@ struct gsicc_link_s {
 /* ICC Cache. The size of the cache is limited by max_memory_size.
  * Links are added if there is sufficient memory and if the number
  * of links does not exceed a (soft) limit.
+ *
+ * The links are spread over a number of shards by their hash, each with
+ * its own list and lock, so that rendering threads sharing the cache only
+ * contend when they look up links that land in the same shard. Finding a
+ * link and releasing it only take the lock of its shard. Adding and
+ * removing links also take the cache lock, which is always taken before
+ * any shard lock.
  */
+#define ICC_CACHE_SHARDS 16
 
-typedef struct gsicc_link_cache_s {
+typedef struct gsicc_link_cache_shard_s {
     gsicc_link_t *head;
+    gx_monitor_t *lock;		/* protects the list and the ref_counts of its links */
+} gsicc_link_cache_shard_t;
+
+typedef struct gsicc_link_cache_s {
+    gsicc_link_cache_shard_t shards[ICC_CACHE_SHARDS];
     int num_links;
     rc_header rc;
     gs_memory_t *memory;
-    gx_monitor_t *lock;		/* handle for the monitor */
+    gx_monitor_t *lock;		/* protects num_links and adding or removing links */
     bool cache_full;		/* flag that some thread needs a cache slot */
     gx_semaphore_t *full_wait;	/* semaphore for waiting when the cache is full */
 } gsicc_link_cache_t;
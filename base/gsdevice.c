@@ -38,6 +38,8 @@
 #include "gsicc_manage.h"
 #include "gscms.h"
 #include "gxgetbit.h"
+#include "gstrace.h"
+#include "gsmemrep.h"
 
 /* Include the extern for the device list. */
 extern_gs_lib_device_list();
@@ -183,8 +185,14 @@ gs_output_page(gs_gstate * pgs, int num_copies, int flush)
 {
     gx_device *dev = gs_currentdevice(pgs);
     cmm_dev_profile_t *dev_profile;
+    int64_t page = dev->PageCount + 1;
+    int64_t start;
     int code;
 
+    /* Everything since the last page (or the start) counts as interpreting this one */
+    start = gs_trace_mark(dev->memory);
+    gs_trace_end(dev->memory, start, "page", "interpret", page);
+
     /* for devices that hook 'fill_path' in order to pick up gs_gstate */
     /* values such as dev_ht (such as tiffsep1), make a dummy call here   */
     /* to make sure that it has been called at least once		  */
@@ -205,7 +213,13 @@ gs_output_page(gs_gstate * pgs, int num_copies, int flush)
 
     if (dev->IgnoreNumCopies)
         num_copies = 1;
-    if ((code = (*dev_proc(dev, output_page)) (dev, num_copies, flush)) < 0)
+    start = gs_trace_begin(dev->memory);
+    code = (*dev_proc(dev, output_page)) (dev, num_copies, flush);
+    gs_trace_end(dev->memory, start, "page", "output_page", page);
+    (void)gs_trace_mark(dev->memory);
+    gs_memreport_page(dev->memory, page, dev->width, dev->height,
+                      gx_device_raster(dev, true));
+    if (code < 0)
         return code;
 
     code = dev_proc(dev, get_profile)(dev, &(dev_profile));
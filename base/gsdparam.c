@@ -501,6 +501,11 @@ int gx_default_get_param(gx_device *dev, char *Param, void *list)
     if (strcmp(Param, "ColorAccuracy") == 0) {
         return param_write_int(plist, "ColorAccuracy", (const int *)(&(color_accuracy)));
     }
+    if (strcmp(Param, "ICCBufferCLUT") == 0) {
+        bool buffer_clut = gsicc_currentbufferclut(dev->memory);
+
+        return param_write_bool(plist, "ICCBufferCLUT", &buffer_clut);
+    }
     if (strcmp(Param, "RenderIntent") == 0) {
         return param_write_int(plist,"RenderIntent", (const int *) (&(profile_intents[0])));
     }
@@ -611,6 +616,7 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
     bool prebandthreshold = true, temp_bool;
     int k;
     int color_accuracy = MAX_COLOR_ACCURACY;
+    bool buffer_clut = gsicc_currentbufferclut(dev->memory);
     gs_param_float_array msa, ibba, hwra, ma;
     gs_param_string_array scna;
     char null_str[1]={'\0'};
@@ -800,6 +806,7 @@ gx_default_get_params(gx_device * dev, gs_param_list * plist)
         (code = param_write_string(plist,"ICCOutputColors", &(icc_colorants))) < 0 ||
         (code = param_write_int(plist, "RenderIntent", (const int *)(&(profile_intents[0])))) < 0 ||
         (code = param_write_int(plist, "ColorAccuracy", (const int *)(&(color_accuracy)))) < 0 ||
+        (code = param_write_bool(plist, "ICCBufferCLUT", &buffer_clut)) < 0 ||
         (code = param_write_int(plist,"VectorIntent", (const int *) &(profile_intents[1]))) < 0 ||
         (code = param_write_int(plist,"ImageIntent", (const int *) &(profile_intents[2]))) < 0 ||
         (code = param_write_int(plist,"TextIntent", (const int *) &(profile_intents[3]))) < 0 ||
@@ -1686,6 +1693,7 @@ gx_default_put_params(gx_device * dev, gs_param_list * plist)
     int leadingedge = dev->LeadingEdge;
     int k;
     int color_accuracy;
+    bool buffer_clut;
     bool devicegraytok = true;
     bool graydetection = false;
     bool usefastcolor = false;
@@ -1703,6 +1711,7 @@ gx_default_put_params(gx_device * dev, gs_param_list * plist)
                                                gsTEXTPROFILE};
 
     color_accuracy = gsicc_currentcoloraccuracy(dev->memory);
+    buffer_clut = gsicc_currentbufferclut(dev->memory);
     if (dev->icc_struct != NULL) {
         for (k = 0; k < NUM_DEVICE_PROFILES; k++) {
             rend_intent[k] = dev->icc_struct->rendercond[k].rendering_intent;
@@ -2056,6 +2065,11 @@ nce:
         ecode = code;
         param_signal_error(plist, param_name, ecode);
     }
+    if ((code = param_read_bool(plist, (param_name = "ICCBufferCLUT"),
+                                                        &buffer_clut)) < 0) {
+        ecode = code;
+        param_signal_error(plist, param_name, ecode);
+    }
     if ((code = param_read_bool(plist, (param_name = "DeviceGrayToK"),
                                                         &devicegraytok)) < 0) {
         ecode = code;
@@ -2525,6 +2539,7 @@ label:\
             return code;
     }
     gsicc_setcoloraccuracy(dev->memory, color_accuracy);
+    gsicc_setbufferclut(dev->memory, buffer_clut);
     code = gx_default_put_graytok(devicegraytok, dev);
     if (code < 0)
         return code;
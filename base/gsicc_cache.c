@@ -36,6 +36,10 @@
 #include "gzstate.h"
 #include "stdint_.h"
 #include "assert_.h"
+#include "gp.h"
+#include "gssprintf.h"
+#include "gslibctx.h"
+#include "gstrace.h"
         /*
          *  Note that the the external memory used to maintain
          *  links in the CMS is generally not visible to GS.
@@ -79,9 +83,35 @@ gs_private_st_ptrs3_final(st_icc_link, gsicc_link_t, "gsiccmanage_link",
 
 struct_proc_finalize(icc_linkcache_finalize);
 
-gs_private_st_ptrs3_final(st_icc_linkcache, gsicc_link_cache_t, "gsiccmanage_linkcache",
-                    icc_linkcache_enum_ptrs, icc_linkcache_reloc_ptrs, icc_linkcache_finalize,
-                    head, lock, full_wait);
+static
+ENUM_PTRS_WITH(icc_linkcache_enum_ptrs, gsicc_link_cache_t *link_cache)
+    index -= 2;
+    if (index < ICC_CACHE_SHARDS)
+        ENUM_RETURN(link_cache->shards[index].head);
+    index -= ICC_CACHE_SHARDS;
+    if (index < ICC_CACHE_SHARDS)
+        ENUM_RETURN(link_cache->shards[index].lock);
+    return 0;
+ENUM_PTR(0, gsicc_link_cache_t, lock);
+ENUM_PTR(1, gsicc_link_cache_t, full_wait);
+ENUM_PTRS_END
+
+static
+RELOC_PTRS_WITH(icc_linkcache_reloc_ptrs, gsicc_link_cache_t *link_cache)
+{
+    int i;
+
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        RELOC_VAR(link_cache->shards[i].head);
+        RELOC_VAR(link_cache->shards[i].lock);
+    }
+    RELOC_PTR(gsicc_link_cache_t, lock);
+    RELOC_PTR(gsicc_link_cache_t, full_wait);
+}
+RELOC_PTRS_END
+
+gs_private_st_composite_use_final(st_icc_linkcache, gsicc_link_cache_t, "gsiccmanage_linkcache",
+                    icc_linkcache_enum_ptrs, icc_linkcache_reloc_ptrs, icc_linkcache_finalize);
 
 /* These are used to construct a hash for the ICC link based upon the
    render parameters */
@@ -99,6 +129,7 @@ gsicc_link_cache_t *
 gsicc_cache_new(gs_memory_t *memory)
 {
     gsicc_link_cache_t *result;
+    int i;
 
     /* We want this to be maintained in stable_memory.  It should be be effected by the
        save and restores */
@@ -107,7 +138,10 @@ gsicc_cache_new(gs_memory_t *memory)
                              "gsicc_cache_new");
     if ( result == NULL )
         return(NULL);
-    result->head = NULL;
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        result->shards[i].head = NULL;
+        result->shards[i].lock = NULL;
+    }
     result->num_links = 0;
     result->cache_full = false;
     result->memory = memory;
@@ -119,6 +153,14 @@ gsicc_cache_new(gs_memory_t *memory)
         rc_decrement(result, "gsicc_cache_new");
         return(NULL);
     }
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        result->shards[i].lock = gx_monitor_label(gx_monitor_alloc(memory),
+                                                  "gsicc_cache_new");
+        if (result->shards[i].lock == NULL) {
+            rc_decrement(result, "gsicc_cache_new");
+            return(NULL);
+        }
+    }
     result->full_wait = gx_semaphore_label(gx_semaphore_alloc(memory),
                                            "gsicc_cache_new");
     if (result->full_wait == NULL) {
@@ -154,6 +196,8 @@ void
 icc_linkcache_finalize(const gs_memory_t *mem, void *ptr)
 {
     gsicc_link_cache_t *link_cache = (gsicc_link_cache_t * ) ptr;
+    gsicc_link_cache_shard_t *shard;
+    int i;
 
     /* The link cache lock is not held here, but presumably we must be safe as
      * we are shutting down. */
@@ -162,13 +206,19 @@ icc_linkcache_finalize(const gs_memory_t *mem, void *ptr)
     assert(link_cache != NULL && mem == link_cache->memory);
     if (link_cache == NULL)
         return;
-    while (link_cache->head != NULL) {
-        if (link_cache->head->ref_count != 0) {
-            if_debug2m(gs_debug_flag_icc, link_cache->memory, "link at "PRI_INTPTR" being removed, but has ref_count = %d\n",
-                      (intptr_t)link_cache->head, link_cache->head->ref_count);
-            link_cache->head->ref_count = 0;	/* force removal */
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        shard = &link_cache->shards[i];
+        /* A failed gsicc_cache_new leaves shards without a lock, or links */
+        if (shard->lock == NULL)
+            continue;
+        while (shard->head != NULL) {
+            if (shard->head->ref_count != 0) {
+                if_debug2m(gs_debug_flag_icc, link_cache->memory, "link at "PRI_INTPTR" being removed, but has ref_count = %d\n",
+                          (intptr_t)shard->head, shard->head->ref_count);
+                shard->head->ref_count = 0;	/* force removal */
+            }
+            gsicc_remove_link(shard->head);
         }
-        gsicc_remove_link(link_cache->head);
     }
 #ifdef DEBUG
     if (link_cache->num_links != 0) {
@@ -176,6 +226,10 @@ icc_linkcache_finalize(const gs_memory_t *mem, void *ptr)
     }
 #endif
     if (link_cache->rc.ref_count == 0) {
+        for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+            gx_monitor_free(link_cache->shards[i].lock);
+            link_cache->shards[i].lock = NULL;
+        }
         gx_monitor_free(link_cache->lock);
         link_cache->lock = NULL;
         gx_semaphore_free(link_cache->full_wait);
@@ -538,20 +592,48 @@ gsicc_get_cspace_hash(gsicc_manager_t *icc_manager, gx_device *dev,
     return 0;
 }
 
+/* The shard of the cache that holds the links with this hash */
+static inline gsicc_link_cache_shard_t *
+gsicc_link_shard(gsicc_link_cache_t *icc_link_cache, int64_t link_hashcode)
+{
+    uint64_t h = (uint64_t)link_hashcode;
+
+    return &icc_link_cache->shards[(uint)(h ^ (h >> 32)) % ICC_CACHE_SHARDS];
+}
+
+/* Drop a reference taken on a cached link that did not get used, removing
+   the link if that was the last one. */
+static void
+gsicc_drop_link_ref(gsicc_link_t *link)
+{
+    gsicc_link_cache_shard_t *shard =
+        gsicc_link_shard(link->icc_link_cache, link->hashcode.link_hashcode);
+    int zerod;
+
+    gx_monitor_enter(shard->lock);
+    link->ref_count--;
+    zerod = link->ref_count == 0;
+    gx_monitor_leave(shard->lock);
+    if (zerod)
+        gsicc_remove_link(link);
+}
+
 gsicc_link_t*
 gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
                     bool includes_proof, bool includes_devlink)
 {
     gsicc_link_t *curr, *prev;
     int64_t hashcode = hash.link_hashcode;
+    gsicc_link_cache_shard_t *shard = gsicc_link_shard(icc_link_cache, hashcode);
     int cache_loop = 0;
 
-    /* Look through the cache for the hashcode */
-    gx_monitor_enter(icc_link_cache->lock);
+    /* Look through the shard for the hashcode. Only the shard is locked, so
+       threads looking up other links are not held up. */
+    gx_monitor_enter(shard->lock);
 
     /* List scanning is fast, so we scan the entire list, this includes   */
     /* links that are currently unused, but still in the cache (zero_ref) */
-    curr = icc_link_cache->head;
+    curr = shard->head;
     prev = NULL;
 
     while (curr != NULL ) {
@@ -563,8 +645,8 @@ gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
             if (prev != NULL) {
                 /* if prev == NULL, curr is already the head */
                 prev->next = curr->next;
-                curr->next = icc_link_cache->head;
-                icc_link_cache->head = curr;
+                curr->next = shard->head;
+                shard->head = curr;
             }
             /* bump the ref_count since we will be using this one */
             curr->ref_count++;
@@ -572,7 +654,7 @@ gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
                        "icclink", (intptr_t)curr, curr->ref_count);
             while (curr->validity != 1) {
                 int invalid = curr->validity == -1;
-                gx_monitor_leave(icc_link_cache->lock); /* exit to let other threads run briefly */
+                gx_monitor_leave(shard->lock); /* exit to let other threads run briefly */
                 if (invalid || cache_loop > ICC_CACHE_NOT_VALID_COUNT) {
                     /* Clearly something is wrong.  Return NULL.
                        File a bug report. */
@@ -581,15 +663,7 @@ gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
                     else
                         emprintf(curr->memory, "Reached maximum invalid counts \n");
                     /* We need to drop our link cache reference. */
-                    {
-                        int zerod;
-                        gx_monitor_enter(icc_link_cache->lock);
-                        curr->ref_count--;
-                        zerod = curr->ref_count == 0;
-                        gx_monitor_leave(icc_link_cache->lock);
-                        if (zerod)
-                            gsicc_remove_link(curr);
-                    }
+                    gsicc_drop_link_ref(curr);
                     return NULL;
                 }
                 cache_loop++;
@@ -601,15 +675,15 @@ gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
                 if (curr->validity != 1) {
                     if_debug1m(gs_debug_flag_icc, curr->memory, "link "PRI_INTPTR" lock released, but still not valid.\n", (intptr_t)curr);	/* Breakpoint here */
                 }
-                gx_monitor_enter(icc_link_cache->lock);	/* re-enter to loop and check */
+                gx_monitor_enter(shard->lock);	/* re-enter to loop and check */
             }
-            gx_monitor_leave(icc_link_cache->lock);
+            gx_monitor_leave(shard->lock);
             return curr;	/* success */
         }
         prev = curr;
         curr = curr->next;
     }
-    gx_monitor_leave(icc_link_cache->lock);
+    gx_monitor_leave(shard->lock);
     return NULL;
 }
 
@@ -619,16 +693,19 @@ gsicc_remove_link(gsicc_link_t *link)
 {
     gsicc_link_t *curr, *prev;
     gsicc_link_cache_t *icc_link_cache = link->icc_link_cache;
+    gsicc_link_cache_shard_t *shard =
+        gsicc_link_shard(icc_link_cache, link->hashcode.link_hashcode);
 
     if_debug2m(gs_debug_flag_icc, link->memory,
                "[icc] Removing link = "PRI_INTPTR" memory = "PRI_INTPTR"\n",
                (intptr_t)link, (intptr_t)link->memory);
     /* NOTE: link->ref_count must be 0: assert ? */
     gx_monitor_enter(icc_link_cache->lock);
+    gx_monitor_enter(shard->lock);
     if (link->ref_count != 0) {
       if_debug2m(gs_debug_flag_icc, link->memory, "link at "PRI_INTPTR" being removed, but has ref_count = %d\n", (intptr_t)link, link->ref_count);
     }
-    curr = icc_link_cache->head;
+    curr = shard->head;
     prev = NULL;
 
     while (curr != NULL ) {
@@ -636,7 +713,7 @@ gsicc_remove_link(gsicc_link_t *link)
         if (curr == link && link->ref_count == 0) {
             /* remove this one from the list */
             if (prev == NULL)
-                icc_link_cache->head = curr->next;
+                shard->head = curr->next;
             else
                 prev->next = curr->next;
             break;
@@ -644,6 +721,7 @@ gsicc_remove_link(gsicc_link_t *link)
         prev = curr;
         curr = curr->next;
     }
+    gx_monitor_leave(shard->lock);
     /* if curr != link we didn't find it or another thread may have decided to */
     /* use it (ref_count > 0). Skip freeing it if so.                          */
     if (curr == link && link->ref_count == 0) {
@@ -901,8 +979,11 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
                        bool include_softproof, bool include_devlink)
 {
     gs_memory_t *cache_mem = icc_link_cache->memory;
+    gsicc_link_cache_shard_t *shard =
+        gsicc_link_shard(icc_link_cache, hash.link_hashcode);
     gsicc_link_t *link;
     int retries = 0;
+    int i;
 
     assert(cache_mem == cache_mem->stable_memory);
 
@@ -910,48 +991,80 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
     /* First see if we can add a link */
     /* TODO: this should be based on memory usage, not just num_links */
     gx_monitor_enter(icc_link_cache->lock);
-    while (icc_link_cache->num_links >= ICC_CACHE_MAXLINKS) {
+    for (;;) {
+        /* Links are only added with the cache lock held, so once we have it
+           check whether another thread added this one since our lookup
+           missed. If so, use that one rather than building it again. */
+        gx_monitor_enter(shard->lock);
+        link = shard->head;
+        while (link != NULL) {
+            if (link->hashcode.link_hashcode == hash.link_hashcode &&
+                include_softproof == link->includes_softproof &&
+                include_devlink == link->includes_devlink &&
+                link->validity != -1)
+                break;
+            link = link->next;
+        }
+        gx_monitor_leave(shard->lock);
+        if (link != NULL) {
+            gx_monitor_leave(icc_link_cache->lock);
+            /* This waits for the link to be valid and bumps its ref_count */
+            *ret_link = gsicc_findcachelink(hash, icc_link_cache,
+                                            include_softproof, include_devlink);
+            if (*ret_link != NULL)
+                return true;
+            /* It went away again before we got it */
+            if (retries++ > 10)
+                return false;
+            gx_monitor_enter(icc_link_cache->lock);
+            continue;
+        }
+        if (icc_link_cache->num_links < ICC_CACHE_MAXLINKS)
+            break;
         /* Look through the cache for first zero ref count to re-use that entry.
            When ref counts go to zero, the icc_link will have been moved to
-           the end of the list, so the first we find is the 'oldest'.
-           If we get to the last entry we release the lock, set the cache_full
+           the end of the list of their shard, so the first we find is the
+           'oldest' of that shard. All the shards are locked while we look, so
+           that a link released meanwhile is either found here or sees the
+           cache_full flag and signals full_wait.
+           If there are none we release the lock, set the cache_full
            flag and wait on full_wait for some other thread to let this thread
            run again after releasing a cache slot. Release the cache lock to
            let other threads run and finish with (release) a cache entry.
         */
-        link = icc_link_cache->head;
-        while (link != NULL ) {
-            if (link->ref_count == 0) {
-                /* we will use this one */
-                if_debug3m('^', cache_mem, "[^]%s "PRI_INTPTR" ++ => %d\n",
-                           "icclink", (intptr_t)link, link->ref_count);
-                break;
+        link = NULL;
+        for (i = 0; i < ICC_CACHE_SHARDS; i++)
+            gx_monitor_enter(icc_link_cache->shards[i].lock);
+        for (i = 0; i < ICC_CACHE_SHARDS && link == NULL; i++) {
+            link = icc_link_cache->shards[i].head;
+            while (link != NULL ) {
+                if (link->ref_count == 0) {
+                    /* we will use this one */
+                    if_debug3m('^', cache_mem, "[^]%s "PRI_INTPTR" ++ => %d\n",
+                               "icclink", (intptr_t)link, link->ref_count);
+                    break;
+                }
+                link = link->next;
             }
-            link = link->next;
         }
-        if (link == NULL) {
+        if (link == NULL)
             icc_link_cache->cache_full = true;
+        for (i = ICC_CACHE_SHARDS - 1; i >= 0; i--)
+            gx_monitor_leave(icc_link_cache->shards[i].lock);
+        if (link == NULL) {
             /* unlock while waiting for a link to come available */
             gx_monitor_leave(icc_link_cache->lock);
             gx_semaphore_wait(icc_link_cache->full_wait);
-            /* repeat the findcachelink to see if some other thread has	*/
-            /* already started building the link we need		*/
-            *ret_link = gsicc_findcachelink(hash, icc_link_cache,
-                                            include_softproof, include_devlink);
-            /* Got a hit, return link. ref_count for the link was already bumped */
-            if (*ret_link != NULL)
-                return true;
-
+            if (retries++ > 10)
+                return false;
             gx_monitor_enter(icc_link_cache->lock);	    /* restore the lock */
             /* we will re-test the num_links above while locked to insure */
             /* that some other thread didn't grab the slot and max us out */
-            if (retries++ > 10)
-                return false;
         } else {
             /* Remove the zero ref_count link profile we found.		*/
             /* Even if we remove this link, we may still be maxed out so*/
-            /* the outermost 'while' will check to make sure some other	*/
-            /* thread did not grab the one we remove.			*/
+            /* the loop will check to make sure some other thread did	*/
+            /* not grab the one we remove.				*/
             gsicc_remove_link(link);
         }
     }
@@ -963,8 +1076,10 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
     /* the lock will be released when the link becomes valid.           */
     if (*ret_link) {
         (*ret_link)->icc_link_cache = icc_link_cache;
-        (*ret_link)->next = icc_link_cache->head;
-        icc_link_cache->head = *ret_link;
+        gx_monitor_enter(shard->lock);
+        (*ret_link)->next = shard->head;
+        shard->head = *ret_link;
+        gx_monitor_leave(shard->lock);
         icc_link_cache->num_links++;
     }
     /* unlock before returning */
@@ -972,6 +1087,188 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
     return false;	/* we didn't find it, but return a link to be filled */
 }
 
+/* Optional on-disk cache of links, enabled with the ICCLinkCacheDir user
+   parameter, so that short jobs do not have to rebuild the same links on
+   every run. Each link is kept in its own file, named from the hashes of
+   the source and destination profiles and from the rendering parameters.
+   The file is a fixed header followed by the link serialized as an ICC
+   device link profile. Anything that does not match the header of the
+   current build and settings is ignored and rewritten. */
+#define GSICC_LINKFILE_MAGIC "GSICCLNK"
+#define GSICC_LINKFILE_VERSION 2
+#define GSICC_LINKFILE_BYTEORDER 0x01020304
+#define GSICC_LINKFILE_MAXSIZE (64 * 1024 * 1024)
+
+typedef struct gsicc_linkfile_header_s {
+    char magic[8];
+    int64_t src_hash;
+    int64_t des_hash;
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t cms_version;
+    uint32_t accuracy;
+    uint32_t cms_flags;
+    uint32_t rendering_intent;
+    uint32_t black_point_comp;
+    uint32_t preserve_black;
+    uint32_t override_icc;
+    uint32_t size;          /* Size of the device link profile that follows */
+} gsicc_linkfile_header_t;
+
+/* The rendering parameters that go into a link, packed into one word */
+static uint
+gsicc_linkfile_rend(const gsicc_rendering_param_t *rendering_params)
+{
+    return ((uint)rendering_params->rendering_intent & 0xff) |
+           (((uint)rendering_params->black_point_comp & 0xff) << 8) |
+           (((uint)rendering_params->preserve_black & 0xff) << 16) |
+           ((rendering_params->override_icc ? 1u : 0u) << 24);
+}
+
+static void
+gsicc_linkfile_header(gs_memory_t *memory, gsicc_hashlink_t *hash,
+                      const gsicc_rendering_param_t *rendering_params,
+                      int cms_flags, gsicc_linkfile_header_t *header)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, GSICC_LINKFILE_MAGIC, sizeof(header->magic));
+    header->src_hash = hash->src_hash;
+    header->des_hash = hash->des_hash;
+    header->version = GSICC_LINKFILE_VERSION;
+    header->byte_order = GSICC_LINKFILE_BYTEORDER;
+    header->cms_version = gscms_get_version();
+    header->accuracy = gs_lib_ctx_get_interp_instance(memory)->icc_color_accuracy;
+    header->cms_flags = cms_flags;
+    header->rendering_intent = rendering_params->rendering_intent;
+    header->black_point_comp = rendering_params->black_point_comp;
+    header->preserve_black = rendering_params->preserve_black;
+    header->override_icc = rendering_params->override_icc;
+}
+
+/* Returns false if there is no cache directory */
+static bool
+gsicc_linkfile_name(gs_memory_t *memory, gsicc_hashlink_t *hash,
+                    const gsicc_rendering_param_t *rendering_params,
+                    int cms_flags, char fname[gp_file_name_sizeof])
+{
+    const char *dir = memory->gs_lib_ctx->icc_link_cache_dir;
+    const char *sep = gp_file_name_directory_separator();
+    size_t dirlen, seplen;
+
+    if (dir == NULL)
+        return false;
+    dirlen = strlen(dir);
+    seplen = strlen(sep);
+    if (dirlen >= seplen && strcmp(dir + dirlen - seplen, sep) == 0)
+        sep = "";
+    return gs_snprintf(fname, gp_file_name_sizeof,
+                       "%s%s%08x%08x%08x%08x%08x%08x.icl", dir, sep,
+                       (uint)((uint64_t)hash->src_hash >> 32),
+                       (uint)hash->src_hash,
+                       (uint)((uint64_t)hash->des_hash >> 32),
+                       (uint)hash->des_hash,
+                       gsicc_linkfile_rend(rendering_params),
+                       (uint)cms_flags) < gp_file_name_sizeof;
+}
+
+static gcmmhlink_t
+gsicc_read_linkfile(gs_memory_t *memory, gsicc_hashlink_t *hash,
+                    const gsicc_rendering_param_t *rendering_params,
+                    int cms_flags)
+{
+    char fname[gp_file_name_sizeof];
+    gsicc_linkfile_header_t expected, header;
+    gp_file *f;
+    unsigned char *buffer = NULL;
+    gcmmhlink_t link_handle = NULL;
+
+    if (!gsicc_linkfile_name(memory, hash, rendering_params, cms_flags, fname))
+        return NULL;
+    f = gp_fopen(memory, fname, "rb");
+    if (f == NULL)
+        return NULL;
+    gsicc_linkfile_header(memory, hash, rendering_params, cms_flags, &expected);
+    if (gp_fread(&header, 1, sizeof(header), f) != sizeof(header))
+        goto done;
+    expected.size = header.size;
+    if (memcmp(&header, &expected, sizeof(header)) != 0 ||
+        header.size == 0 || header.size > GSICC_LINKFILE_MAXSIZE)
+        goto done;
+    buffer = gs_alloc_bytes(memory->non_gc_memory, header.size,
+                            "gsicc_read_linkfile");
+    if (buffer == NULL)
+        goto done;
+    if (gp_fread(buffer, 1, header.size, f) != header.size)
+        goto done;
+    link_handle = gscms_get_link_from_devlink_buffer(buffer, header.size,
+                                                     cms_flags, memory);
+    if_debug2m(gs_debug_flag_icc, memory, "[icc] Read link file %s: %s\n",
+               fname, link_handle != NULL ? "ok" : "failed");
+done:
+    gs_free_object(memory->non_gc_memory, buffer, "gsicc_read_linkfile");
+    gp_fclose(f);
+    return link_handle;
+}
+
+/* A link read back from a file is table based and does not give exactly
+   the results of the link it was saved from. So that a job gives the same
+   output whether or not its links were already on disk, a newly built link
+   is replaced by the one recreated from the bytes written to the file, and
+   that is what gets used. The original link_handle is released through
+   link. If the link cannot be serialized it is returned unchanged and not
+   cached. The file is written to a scratch file in the cache directory and
+   then renamed, so that other processes never see a partly written link.
+   Failures to write are not errors; the link just does not get cached. */
+static gcmmhlink_t
+gsicc_write_linkfile(gs_memory_t *memory, gsicc_link_t *link,
+                     gcmmhlink_t link_handle, gsicc_hashlink_t *hash,
+                     const gsicc_rendering_param_t *rendering_params,
+                     int cms_flags)
+{
+    char fname[gp_file_name_sizeof];
+    char tmpname[gp_file_name_sizeof];
+    char prefix[gp_file_name_sizeof];
+    gsicc_linkfile_header_t header;
+    unsigned char *buffer;
+    unsigned int size;
+    gcmmhlink_t file_handle;
+    gp_file *f;
+    bool ok;
+    int code;
+
+    if (!gsicc_linkfile_name(memory, hash, rendering_params, cms_flags, fname))
+        return link_handle;
+    code = gscms_get_link_devlink_buffer(link_handle, &buffer, &size, memory);
+    if (code < 0)
+        return link_handle;
+    file_handle = gscms_get_link_from_devlink_buffer(buffer, size, cms_flags,
+                                                     memory);
+    if (file_handle == NULL) {
+        gs_free_object(memory->non_gc_memory, buffer, "gsicc_write_linkfile");
+        return link_handle;
+    }
+    link->link_handle = link_handle;
+    link->procs.free_link(link);
+    /* The scratch file goes next to the final one. */
+    strcpy(prefix, fname);
+    strcpy(prefix + strlen(prefix) - 4, "_");
+    f = gp_open_scratch_file(memory, prefix, tmpname, "wb");
+    if (f != NULL) {
+        gsicc_linkfile_header(memory, hash, rendering_params, cms_flags,
+                              &header);
+        header.size = size;
+        ok = gp_fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+             gp_fwrite(buffer, 1, size, f) == size;
+        ok = (gp_fclose(f) == 0) && ok;
+        if (!ok || gp_rename(memory, tmpname, fname) != 0)
+            gp_unlink(memory, tmpname);
+        if_debug2m(gs_debug_flag_icc, memory, "[icc] Wrote link file %s: %s\n",
+                   fname, ok ? "ok" : "failed");
+    }
+    gs_free_object(memory->non_gc_memory, buffer, "gsicc_write_linkfile");
+    return file_handle;
+}
+
 /* This is the main function called to obtain a linked transform from the ICC
    cache If the cache has the link ready, it will return it.  If not, it will
    request one from the CMS and then return it.  We may need to do some cache
@@ -1005,6 +1302,8 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
     bool src_dev_link = gs_input_profile->isdevlink;
     bool pageneutralcolor = false;
     int cms_flags = 0;
+    bool use_linkfile = true;
+    int64_t start;
 
     /* Determine if we are using a soft proof or device link profile */
     if (dev != NULL ) {
@@ -1247,8 +1546,11 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
         /* Turn off bp compensation in this case as there is a bug in lcms */
         rendering_params->black_point_comp = false;
         cms_flags = 0;  /* Turn off any flag setting */
+        /* This substitution is not reflected in the link hash */
+        use_linkfile = false;
     }
     /* Get the link with the proof and or device link profile */
+    start = gs_trace_begin(cache_mem);
     if (include_softproof || include_devicelink || src_dev_link) {
         link_handle = gscms_get_link_proof_devlink(cms_input_profile,
                                                    cms_proof_profile,
@@ -1266,10 +1568,24 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
         }
     }
     } else {
-        link_handle = gscms_get_link(cms_input_profile, cms_output_profile,
-                                     rendering_params, cms_flags,
-                                     cache_mem->non_gc_memory);
+        /* gscms_get_link can change the intent, so keep a copy of the
+           parameters for the link file */
+        gsicc_rendering_param_t link_params = *rendering_params;
+
+        if (use_linkfile)
+            link_handle = gsicc_read_linkfile(cache_mem->non_gc_memory, &hash,
+                                              &link_params, cms_flags);
+        if (link_handle == NULL) {
+            link_handle = gscms_get_link(cms_input_profile, cms_output_profile,
+                                         rendering_params, cms_flags,
+                                         cache_mem->non_gc_memory);
+            if (link_handle != NULL && use_linkfile)
+                link_handle = gsicc_write_linkfile(cache_mem->non_gc_memory,
+                                                   link, link_handle, &hash,
+                                                   &link_params, cms_flags);
+        }
     }
+    gs_trace_end(cache_mem, start, "icc", "create_link", -1);
     if (!gscms_is_threadsafe()) {
         if (!src_dev_link) {
             gx_monitor_leave(gs_output_profile->lock);
@@ -1319,15 +1635,18 @@ drop_link_ref:
        (e.g. profile handles) would get freed when the profiles
         are freed */
     {
+        gsicc_link_cache_shard_t *shard =
+            gsicc_link_shard(icc_link_cache, link->hashcode.link_hashcode);
         int zerod;
-        gx_monitor_enter(icc_link_cache->lock);
+
+        gx_monitor_enter(shard->lock);
         link->ref_count--;
         zerod = link->ref_count == 0;
-        gx_monitor_leave(icc_link_cache->lock);
+        if (!zerod)
+            link->validity = -1;
+        gx_monitor_leave(shard->lock);
         if (zerod)
             gsicc_remove_link(link);
-        else
-            link->validity = -1;
     }
 
     return NULL;
@@ -1821,13 +2140,15 @@ void
 gsicc_release_link(gsicc_link_t *icclink)
 {
     gsicc_link_cache_t *icc_link_cache;
+    gsicc_link_cache_shard_t *shard;
 
     if (icclink == NULL)
         return;
 
     icc_link_cache = icclink->icc_link_cache;
+    shard = gsicc_link_shard(icc_link_cache, icclink->hashcode.link_hashcode);
 
-    gx_monitor_enter(icc_link_cache->lock);
+    gx_monitor_enter(shard->lock);
     if_debug2m('^', icclink->memory, "[^]icclink "PRI_INTPTR" -- => %d\n",
                (intptr_t)icclink, icclink->ref_count - 1);
     /* Decrement the reference count */
@@ -1835,9 +2156,9 @@ gsicc_release_link(gsicc_link_t *icclink)
 
         gsicc_link_t *curr, *prev;
 
-        /* Find link in cache, and move it to the end of the list.  */
+        /* Find link in the shard, and move it to the end of the list.  */
         /* This way zero ref_count links are found LRU first	*/
-        curr = icc_link_cache->head;
+        curr = shard->head;
         prev = NULL;
         while (curr != icclink) {
             prev = curr;
@@ -1845,12 +2166,12 @@ gsicc_release_link(gsicc_link_t *icclink)
         };
         if (prev == NULL) {
             /* this link was the head */
-            icc_link_cache->head = curr->next;
+            shard->head = curr->next;
         } else {
             prev->next = curr->next;		/* de-link this one */
         }
         /* Find the first zero-ref entry on the list */
-        curr = icc_link_cache->head;
+        curr = shard->head;
         prev = NULL;
         while (curr != NULL && curr->ref_count > 0) {
             prev = curr;
@@ -1858,20 +2179,21 @@ gsicc_release_link(gsicc_link_t *icclink)
         }
         /* Found where to link this one into the tail of the list */
         if (prev == NULL) {
-            icc_link_cache->head = icclink;
-            icclink->next = icc_link_cache->head->next;
+            icclink->next = shard->head;
+            shard->head = icclink;
         } else {
             /* link this one in here */
             prev->next = icclink;
             icclink->next = curr;
         }
-        /* Finally, if some thread was waiting because the cache was full, let it run */
+        /* Finally, if some thread was waiting because the cache was full, let it run.
+           gsicc_alloc_link_entry sets the flag with all the shards locked. */
         if (icc_link_cache->cache_full) {
             icc_link_cache->cache_full = false;
             gx_semaphore_signal(icc_link_cache->full_wait);	/* let a waiting thread run */
         }
     }
-    gx_monitor_leave(icc_link_cache->lock);
+    gx_monitor_leave(shard->lock);
 }
 
 /* Used to initialize the buffer description prior to color conversion */
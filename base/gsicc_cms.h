@@ -76,6 +76,12 @@ gcmmhlink_t gscms_get_link_proof_devlink(gcmmhprofile_t lcms_srchandle,
                                          gsicc_rendering_param_t *rendering_params,
                                          bool src_dev_link, int cmm_flags,
                                          gs_memory_t *memory);
+int gscms_get_link_devlink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                                  unsigned int *size, gs_memory_t *memory);
+gcmmhlink_t gscms_get_link_from_devlink_buffer(unsigned char *buffer,
+                                               unsigned int size, int cmm_flags,
+                                               gs_memory_t *memory);
+int gscms_get_version(void);
 void *gscms_create(gs_memory_t *memory);
 void gscms_destroy(void *);
 void gscms_release_link(gsicc_link_t *icclink);
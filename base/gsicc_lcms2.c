@@ -588,6 +588,85 @@ gscms_get_link(gcmmhprofile_t  lcms_srchandle,
     /* cmsFLAGS_HIGHRESPRECALC)  cmsFLAGS_NOTPRECALC  cmsFLAGS_LOWRESPRECALC*/
 }
 
+/* Serialize a link as an ICC device link profile so that it can be
+   stored in the on-disk link cache. The buffer is allocated in
+   memory->non_gc_memory and must be freed by the caller. Links that
+   start or end in a PCS cannot be expressed as a device link and give
+   an error. */
+int
+gscms_get_link_devlink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                              unsigned int *size, gs_memory_t *memory)
+{
+    cmsHPROFILE devlink;
+    cmsUInt32Number bytes = 0;
+    unsigned char *buf;
+
+    *buffer = NULL;
+    *size = 0;
+    devlink = cmsTransform2DeviceLink(link, 4.3, 0);
+    if (devlink == NULL)
+        return_error(gs_error_unknownerror);
+    if (cmsGetDeviceClass(devlink) != cmsSigLinkClass ||
+        !cmsSaveProfileToMem(devlink, NULL, &bytes) || bytes == 0) {
+        cmsCloseProfile(devlink);
+        return_error(gs_error_unknownerror);
+    }
+    buf = gs_alloc_bytes(memory->non_gc_memory, bytes,
+                         "gscms_get_link_devlink_buffer");
+    if (buf == NULL) {
+        cmsCloseProfile(devlink);
+        return_error(gs_error_VMerror);
+    }
+    if (!cmsSaveProfileToMem(devlink, buf, &bytes)) {
+        gs_free_object(memory->non_gc_memory, buf,
+                       "gscms_get_link_devlink_buffer");
+        cmsCloseProfile(devlink);
+        return_error(gs_error_unknownerror);
+    }
+    cmsCloseProfile(devlink);
+    *buffer = buf;
+    *size = bytes;
+    return 0;
+}
+
+/* Recreate a link from a device link profile written by
+   gscms_get_link_devlink_buffer. The pipeline is stored in AToB0, so
+   the intent is always perceptual, and black point compensation does
+   not apply to device links. */
+gcmmhlink_t
+gscms_get_link_from_devlink_buffer(unsigned char *buffer, unsigned int size,
+                                   int cmm_flags, gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    cmsHPROFILE devlink;
+    gsicc_rendering_param_t rendering_params;
+    gcmmhlink_t link;
+
+    devlink = cmsOpenProfileFromMemTHR(ctx, buffer, size);
+    if (devlink == NULL)
+        return NULL;
+    if (cmsGetDeviceClass(devlink) != cmsSigLinkClass) {
+        cmsCloseProfile(devlink);
+        return NULL;
+    }
+    rendering_params.black_point_comp = gsBLACKPTCOMP_OFF;
+    rendering_params.preserve_black = gsBLACKPRESERVE_OFF;
+    rendering_params.rendering_intent = gsPERCEPTUAL;
+    rendering_params.graphics_type_tag = GS_UNKNOWN_TAG;
+    rendering_params.cmm = gsCMM_DEFAULT;
+    rendering_params.override_icc = false;
+    link = gscms_get_link(devlink, NULL, &rendering_params, cmm_flags, memory);
+    cmsCloseProfile(devlink);
+    return link;
+}
+
+/* Version of the CMM, recorded in the on-disk link cache */
+int
+gscms_get_version(void)
+{
+    return cmsGetEncodedCMMversion();
+}
+
 /* Get the link from the CMS, but include proofing and/or a device link
    profile.  Note also, that the source may be a device link profile, in
    which case we will not have a destination profile but could still have
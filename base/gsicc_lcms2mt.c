@@ -23,6 +23,7 @@
 #include "gserrors.h"
 #include "gp.h"
 #include "gsicc_cms.h"
+#include "stdint_.h"
 #include "gxdevice.h"
 
 #ifdef WITH_CAL
@@ -46,10 +47,36 @@
      (endianswapIN != 0) << 3 | (endianswapOUT != 0) << 2 | \
      (bytesIN == 1) << 1 | (bytesOUT == 1))
 
+/* Without CAL, and with -dICCBufferCLUT, 8 bit RGB and CMYK buffer
+   transforms are done from a table of the link sampled on the same grid
+   that lcms would use for its own precalculated transform, interpolated
+   with the same tetrahedral scheme, but without the per pixel format
+   packing and unpacking of lcms. The results can differ from lcms by a
+   code value, so this is off by default. CAL provides its own optimized
+   transforms. */
+#ifndef WITH_CAL
+#define USE_FAST_CLUT
+#endif
+
+#define FAST_CLUT_FRAC_BITS 12
+#define FAST_CLUT_MAX_OUT 4
+
+typedef struct gsicc_lcms2mt_clut_s {
+    int num_in;
+    int num_out;
+    int grid;
+    unsigned short *table;      /* grid^num_in entries of num_out values */
+    unsigned int offset[4][256];  /* table offset of the cell for each input value */
+    unsigned short frac[256];   /* position within the cell, 0 to 1 << FAST_CLUT_FRAC_BITS */
+} gsicc_lcms2mt_clut_t;
+
 typedef struct gsicc_lcms2mt_link_list_s {
     int flags;
     cmsHTRANSFORM *hTransform;
     struct gsicc_lcms2mt_link_list_s *next;
+    /* Only used in the first entry of the list */
+    gsicc_lcms2mt_clut_t *clut;
+    int clut_state;             /* 0 not tried yet, 1 built, -1 not possible */
 } gsicc_lcms2mt_link_list_t;
 
 /* Only provide warning about issues in lcms if debug build */
@@ -328,6 +355,252 @@ gscms_get_profile_handle_file(const char *filename, gs_memory_t *mem)
     return cmsOpenProfileFromFile(ctx, filename, "r");
 }
 
+#ifdef USE_FAST_CLUT
+/* Same grid sizes as lcms uses for its precalculated transforms, so the
+   table nodes are the nodes of the lcms transform. */
+static int
+gsicc_fast_clut_grid(int num_in, unsigned int accuracy)
+{
+    if (accuracy & cmsFLAGS_HIGHRESPRECALC)
+        return num_in == 4 ? 23 : 49;
+    if (accuracy & cmsFLAGS_LOWRESPRECALC)
+        return 17;
+    return num_in == 4 ? 17 : 33;
+}
+
+/* Sample the 16 bit chunky transform at the head of the list on a regular
+   grid. Returns NULL if the link is not a kind we handle. */
+static gsicc_lcms2mt_clut_t *
+gsicc_fast_clut_build(gsicc_lcms2mt_link_list_t *link_handle, gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    cmsHTRANSFORM hTransform = link_handle->hTransform;
+    cmsUInt32Number in_format = cmsGetTransformInputFormat(ctx, hTransform);
+    cmsUInt32Number out_format = cmsGetTransformOutputFormat(ctx, hTransform);
+    int num_in = T_CHANNELS(in_format);
+    int num_out = T_CHANNELS(out_format);
+    int out_space = T_COLORSPACE(out_format);
+    gsicc_lcms2mt_clut_t *clut;
+    unsigned short *input;
+    int grid, num_nodes, stride, i, j, k, v;
+
+    if (!((T_COLORSPACE(in_format) == PT_RGB && num_in == 3) ||
+          (T_COLORSPACE(in_format) == PT_CMYK && num_in == 4)))
+        return NULL;
+    if (num_out < 1 || num_out > FAST_CLUT_MAX_OUT ||
+        !(out_space == PT_GRAY || out_space == PT_RGB || out_space == PT_CMYK))
+        return NULL;
+
+    grid = gsicc_fast_clut_grid(num_in, gscms_get_accuracy(memory));
+    num_nodes = 1;
+    for (i = 0; i < num_in; i++)
+        num_nodes *= grid;
+
+    clut = (gsicc_lcms2mt_clut_t *)gs_alloc_bytes(memory->non_gc_memory,
+                                                  sizeof(gsicc_lcms2mt_clut_t),
+                                                  "gsicc_fast_clut_build");
+    if (clut == NULL)
+        return NULL;
+    clut->table = (unsigned short *)gs_alloc_bytes(memory->non_gc_memory,
+                                                   (size_t)num_nodes * num_out * sizeof(unsigned short),
+                                                   "gsicc_fast_clut_build");
+    input = (unsigned short *)gs_alloc_bytes(memory->non_gc_memory,
+                                             (size_t)num_nodes * num_in * sizeof(unsigned short),
+                                             "gsicc_fast_clut_build");
+    if (clut->table == NULL || input == NULL) {
+        gs_free_object(memory->non_gc_memory, input, "gsicc_fast_clut_build");
+        gs_free_object(memory->non_gc_memory, clut->table, "gsicc_fast_clut_build");
+        gs_free_object(memory->non_gc_memory, clut, "gsicc_fast_clut_build");
+        return NULL;
+    }
+    clut->num_in = num_in;
+    clut->num_out = num_out;
+    clut->grid = grid;
+
+    /* The last input varies fastest */
+    for (j = 0; j < num_nodes; j++) {
+        int n = j;
+
+        for (i = num_in - 1; i >= 0; i--) {
+            input[j * num_in + i] =
+                (unsigned short)(((n % grid) * 65535 + (grid - 1) / 2) / (grid - 1));
+            n /= grid;
+        }
+    }
+    cmsDoTransform(ctx, hTransform, input, clut->table, num_nodes);
+    gs_free_object(memory->non_gc_memory, input, "gsicc_fast_clut_build");
+
+    /* The cell and the position in it for each 8 bit input value. The
+       last node is reached as the far corner of the last cell. */
+    for (v = 0; v < 256; v++) {
+        int pos = v * (grid - 1);
+        int cell = pos / 255;
+        int frac = (((pos % 255) << FAST_CLUT_FRAC_BITS) + 127) / 255;
+
+        if (cell == grid - 1) {
+            cell--;
+            frac = 1 << FAST_CLUT_FRAC_BITS;
+        }
+        clut->frac[v] = frac;
+        stride = num_out;
+        for (k = num_in - 1; k >= 0; k--) {
+            clut->offset[k][v] = cell * stride;
+            stride *= grid;
+        }
+    }
+    return clut;
+}
+
+/* The order of the axes from the largest to the smallest fraction, indexed
+   by the results of comparing the fractions. 3 and 4 cannot happen. */
+static const unsigned char fast_clut_order[8][3] = {
+    {2, 1, 0}, {2, 0, 1}, {1, 2, 0}, {0, 1, 2},
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {0, 1, 2}
+};
+
+/* Tetrahedral interpolation in the 3D cell at base, whose corners are dx,
+   dy and dz apart, giving 16 bit results scaled by 1 << FAST_CLUT_FRAC_BITS.
+   We walk from the near to the far corner of the cell along the edges in
+   the order of decreasing fraction, choosing the order without branches
+   as these mispredict badly on noisy image data. */
+static forceinline void
+gsicc_fast_clut_tetra(const unsigned short *base, int dx, int dy, int dz,
+                      int rx, int ry, int rz, int num_out, unsigned int *out)
+{
+    const unsigned short *c1, *c2, *c3;
+    int d[3], r[3];
+    const unsigned char *order;
+    int w0, w1, w2, w3, k;
+
+    d[0] = dx; d[1] = dy; d[2] = dz;
+    r[0] = rx; r[1] = ry; r[2] = rz;
+    order = fast_clut_order[(rx >= ry) | (ry >= rz) << 1 | (rx >= rz) << 2];
+    c1 = base + d[order[0]];
+    c2 = c1 + d[order[1]];
+    c3 = c2 + d[order[2]];
+    w1 = r[order[0]] - r[order[1]];
+    w2 = r[order[1]] - r[order[2]];
+    w3 = r[order[2]];
+    w0 = (1 << FAST_CLUT_FRAC_BITS) - w1 - w2 - w3;
+    for (k = 0; k < num_out; k++)
+        out[k] = base[k] * w0 + c1[k] * w1 + c2[k] * w2 + c3[k] * w3;
+}
+
+/* 16 bit to 8 bit as lcms does it */
+#define FAST_CLUT_ROUND (1 << (FAST_CLUT_FRAC_BITS - 1))
+#define FAST_CLUT_TO_8(v) ((byte)(((((v) + FAST_CLUT_ROUND) >> FAST_CLUT_FRAC_BITS) * 65281U + 8388608U) >> 24))
+
+/* Chunky or planar 8 bit buffers, no alpha. Inlined for each number of
+   inputs and outputs, so that the loops over the channels unroll. */
+static forceinline void
+gsicc_fast_clut_transform_n(const gsicc_lcms2mt_clut_t *clut,
+                            const gsicc_bufferdesc_t *input_buff_desc,
+                            const gsicc_bufferdesc_t *output_buff_desc,
+                            const byte *inputbuffer, byte *outputbuffer,
+                            int num_in, int num_out)
+{
+    const unsigned short *table = clut->table;
+    int grid = clut->grid;
+    int in_pix, in_chan, out_pix, out_chan;
+    /* Distances between neighbouring nodes along each input. With 3
+       inputs, the strides are those of the last 3 of 4 inputs. */
+    int d1 = num_out * grid * grid, d2 = num_out * grid, d3 = num_out;
+    int d0 = d1 * grid;
+    unsigned int res[FAST_CLUT_MAX_OUT], res1[FAST_CLUT_MAX_OUT];
+    byte last_out[FAST_CLUT_MAX_OUT];
+    uint32_t key, last_key = 0;
+    bool have_last = false;
+    int x, y, k;
+
+    if (input_buff_desc->is_planar) {
+        in_pix = 1;
+        in_chan = input_buff_desc->plane_stride;
+    } else {
+        in_pix = num_in;
+        in_chan = 1;
+    }
+    if (output_buff_desc->is_planar) {
+        out_pix = 1;
+        out_chan = output_buff_desc->plane_stride;
+    } else {
+        out_pix = num_out;
+        out_chan = 1;
+    }
+    for (y = 0; y < input_buff_desc->num_rows; y++) {
+        const byte *in = inputbuffer + (size_t)y * input_buff_desc->row_stride;
+        byte *out = outputbuffer + (size_t)y * output_buff_desc->row_stride;
+
+        for (x = 0; x < input_buff_desc->pixels_per_row; x++, in += in_pix, out += out_pix) {
+            int c0 = in[0], c1 = in[in_chan], c2 = in[2 * in_chan];
+            int c3 = num_in == 4 ? in[3 * in_chan] : 0;
+
+            key = c0 | c1 << 8 | c2 << 16 | (uint32_t)c3 << 24;
+            /* Runs of one color are common, e.g. in scanned pages */
+            if (key != last_key || !have_last) {
+                if (num_in == 3) {
+                    gsicc_fast_clut_tetra(table + clut->offset[0][c0] +
+                                          clut->offset[1][c1] + clut->offset[2][c2],
+                                          d1, d2, d3, clut->frac[c0], clut->frac[c1],
+                                          clut->frac[c2], num_out, res);
+                } else {
+                    /* Interpolate between the 3D results in the cells on
+                       either side along the first input, as lcms does */
+                    const unsigned short *base = table + clut->offset[0][c0] +
+                        clut->offset[1][c1] + clut->offset[2][c2] +
+                        clut->offset[3][c3];
+                    int r0 = clut->frac[c0];
+
+                    gsicc_fast_clut_tetra(base, d1, d2, d3, clut->frac[c1],
+                                          clut->frac[c2], clut->frac[c3], num_out, res);
+                    gsicc_fast_clut_tetra(base + d0, d1, d2, d3, clut->frac[c1],
+                                          clut->frac[c2], clut->frac[c3], num_out, res1);
+                    for (k = 0; k < num_out; k++) {
+                        unsigned int v0 = (res[k] + FAST_CLUT_ROUND) >> FAST_CLUT_FRAC_BITS;
+                        unsigned int v1 = (res1[k] + FAST_CLUT_ROUND) >> FAST_CLUT_FRAC_BITS;
+
+                        res[k] = v0 * ((1 << FAST_CLUT_FRAC_BITS) - r0) + v1 * r0;
+                    }
+                }
+                for (k = 0; k < num_out; k++)
+                    last_out[k] = FAST_CLUT_TO_8(res[k]);
+                last_key = key;
+                have_last = true;
+            }
+            for (k = 0; k < num_out; k++)
+                out[k * out_chan] = last_out[k];
+        }
+    }
+}
+
+static void
+gsicc_fast_clut_transform(const gsicc_lcms2mt_clut_t *clut,
+                          const gsicc_bufferdesc_t *input_buff_desc,
+                          const gsicc_bufferdesc_t *output_buff_desc,
+                          const byte *inputbuffer, byte *outputbuffer)
+{
+#define FAST_CLUT_CASE(I, O)\
+    case (I) * 8 + (O):\
+        gsicc_fast_clut_transform_n(clut, input_buff_desc, output_buff_desc,\
+                                    inputbuffer, outputbuffer, I, O);\
+        break
+
+    switch (clut->num_in * 8 + clut->num_out) {
+    FAST_CLUT_CASE(3, 1);
+    FAST_CLUT_CASE(3, 3);
+    FAST_CLUT_CASE(3, 4);
+    FAST_CLUT_CASE(4, 1);
+    FAST_CLUT_CASE(4, 3);
+    FAST_CLUT_CASE(4, 4);
+    default:
+        gsicc_fast_clut_transform_n(clut, input_buff_desc, output_buff_desc,
+                                    inputbuffer, outputbuffer,
+                                    clut->num_in, clut->num_out);
+        break;
+    }
+#undef FAST_CLUT_CASE
+}
+#endif
+
 /* Transform an entire buffer */
 int
 gscms_transform_color_buffer(gx_device *dev, gsicc_link_t *icclink,
@@ -379,6 +652,29 @@ gscms_transform_color_buffer(gx_device *dev, gsicc_link_t *icclink,
     needed_flags = gsicc_link_flags(hasalpha, planarIN, planarOUT,
                                     swap_endianIN, swap_endianOUT,
                                     numbytesIN, numbytesOUT);
+#ifdef USE_FAST_CLUT
+    if (numbytesIN == 1 && numbytesOUT == 1 && !hasalpha &&
+        gs_lib_ctx_get_interp_instance(icclink->memory)->icc_buffer_clut) {
+        gsicc_lcms2mt_clut_t *clut;
+
+        /* Rendering threads can share the link, so only look at the table
+           with the link locked. The first 8 bit buffer builds it. */
+        gx_monitor_enter(icclink->lock);
+        if (link_handle->clut_state == 0) {
+            link_handle->clut = gsicc_fast_clut_build(link_handle, icclink->memory);
+            link_handle->clut_state = link_handle->clut != NULL ? 1 : -1;
+        }
+        clut = link_handle->clut;
+        gx_monitor_leave(icclink->lock);
+
+        if (clut != NULL && clut->num_in == input_buff_desc->num_chan &&
+            clut->num_out == output_buff_desc->num_chan) {
+            gsicc_fast_clut_transform(clut, input_buff_desc,
+                                      output_buff_desc, inputbuffer, outputbuffer);
+            return 0;
+        }
+    }
+#endif
     while (link_handle->flags != needed_flags) {
         if (link_handle->next == NULL) {
             hTransform = NULL;
@@ -399,6 +695,8 @@ gscms_transform_color_buffer(gx_device *dev, gsicc_link_t *icclink,
         }
         new_link_handle->next = NULL;		/* new end of list */
         new_link_handle->flags = needed_flags;
+        new_link_handle->clut = NULL;
+        new_link_handle->clut_state = -1;
         hTransform = link_handle->hTransform;	/* doesn't really matter which we start with */
         /* Color space MUST be the same */
         dwInputFormat = COLORSPACE_SH(T_COLORSPACE(cmsGetTransformInputFormat(ctx, hTransform)));
@@ -520,6 +818,8 @@ gscms_transform_color_const(const gx_device *dev, gsicc_link_t *icclink, void *i
         }
         new_link_handle->next = NULL;		/* new end of list */
         new_link_handle->flags = needed_flags;
+        new_link_handle->clut = NULL;
+        new_link_handle->clut_state = -1;
         hTransform = link_handle->hTransform;
 
         /* the variant we want wasn't present, clone it from the HEAD (no alpha, not planar) */
@@ -699,10 +999,93 @@ gscms_get_link(gcmmhprofile_t  lcms_srchandle, gcmmhprofile_t lcms_deshandle,
     link_handle->next = NULL;
     link_handle->flags = gsicc_link_flags(0, 0, 0, 0, 0,    /* no alpha, not planar, no endian swap */
                                           sizeof(gx_color_value), sizeof(gx_color_value));
+    link_handle->clut = NULL;
+    link_handle->clut_state = 0;
     return link_handle;
     /* cmsFLAGS_HIGHRESPRECALC)  cmsFLAGS_NOTPRECALC  cmsFLAGS_LOWRESPRECALC*/
 }
 
+/* Serialize a link as an ICC device link profile so that it can be
+   stored in the on-disk link cache. The buffer is allocated in
+   memory->non_gc_memory and must be freed by the caller. Links that
+   start or end in a PCS cannot be expressed as a device link and give
+   an error. */
+int
+gscms_get_link_devlink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                              unsigned int *size, gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    gsicc_lcms2mt_link_list_t *link_handle = (gsicc_lcms2mt_link_list_t *)(link);
+    cmsHPROFILE devlink;
+    cmsUInt32Number bytes = 0;
+    unsigned char *buf;
+
+    *buffer = NULL;
+    *size = 0;
+    devlink = cmsTransform2DeviceLink(ctx, link_handle->hTransform, 4.3, 0);
+    if (devlink == NULL)
+        return_error(gs_error_unknownerror);
+    if (cmsGetDeviceClass(ctx, devlink) != cmsSigLinkClass ||
+        !cmsSaveProfileToMem(ctx, devlink, NULL, &bytes) || bytes == 0) {
+        cmsCloseProfile(ctx, devlink);
+        return_error(gs_error_unknownerror);
+    }
+    buf = gs_alloc_bytes(memory->non_gc_memory, bytes,
+                         "gscms_get_link_devlink_buffer");
+    if (buf == NULL) {
+        cmsCloseProfile(ctx, devlink);
+        return_error(gs_error_VMerror);
+    }
+    if (!cmsSaveProfileToMem(ctx, devlink, buf, &bytes)) {
+        gs_free_object(memory->non_gc_memory, buf,
+                       "gscms_get_link_devlink_buffer");
+        cmsCloseProfile(ctx, devlink);
+        return_error(gs_error_unknownerror);
+    }
+    cmsCloseProfile(ctx, devlink);
+    *buffer = buf;
+    *size = bytes;
+    return 0;
+}
+
+/* Recreate a link from a device link profile written by
+   gscms_get_link_devlink_buffer. The pipeline is stored in AToB0, so
+   the intent is always perceptual, and black point compensation does
+   not apply to device links. */
+gcmmhlink_t
+gscms_get_link_from_devlink_buffer(unsigned char *buffer, unsigned int size,
+                                   int cmm_flags, gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    cmsHPROFILE devlink;
+    gsicc_rendering_param_t rendering_params;
+    gcmmhlink_t link;
+
+    devlink = cmsOpenProfileFromMem(ctx, buffer, size);
+    if (devlink == NULL)
+        return NULL;
+    if (cmsGetDeviceClass(ctx, devlink) != cmsSigLinkClass) {
+        cmsCloseProfile(ctx, devlink);
+        return NULL;
+    }
+    rendering_params.black_point_comp = gsBLACKPTCOMP_OFF;
+    rendering_params.preserve_black = gsBLACKPRESERVE_OFF;
+    rendering_params.rendering_intent = gsPERCEPTUAL;
+    rendering_params.graphics_type_tag = GS_UNKNOWN_TAG;
+    rendering_params.cmm = gsCMM_DEFAULT;
+    rendering_params.override_icc = false;
+    link = gscms_get_link(devlink, NULL, &rendering_params, cmm_flags, memory);
+    cmsCloseProfile(ctx, devlink);
+    return link;
+}
+
+/* Version of the CMM, recorded in the on-disk link cache */
+int
+gscms_get_version(void)
+{
+    return cmsGetEncodedCMMversion();
+}
+
 /* Get the link from the CMS, but include proofing and/or a device link
    profile.  Note also, that the source may be a device link profile, in
    which case we will not have a destination profile but could still have
@@ -734,6 +1117,8 @@ gscms_get_link_proof_devlink(gcmmhprofile_t lcms_srchandle,
     link_handle->next = NULL;
     link_handle->flags = gsicc_link_flags(0, 0, 0, 0, 0,    /* no alpha, not planar, no endian swap */
                                           sizeof(gx_color_value), sizeof(gx_color_value));
+    link_handle->clut = NULL;
+    link_handle->clut_state = 0;
     /* Check if the rendering intent is something other than relative colorimetric
        and if we have a proofing profile.  In this case we need to create the
        combined profile a bit different.  LCMS does not allow us to use different
@@ -921,6 +1306,12 @@ gscms_release_link(gsicc_link_t *icclink)
     while (link_handle != NULL) {
         gsicc_lcms2mt_link_list_t *next_handle;
         cmsDeleteTransform(ctx, link_handle->hTransform);
+        if (link_handle->clut != NULL) {
+            gs_free_object(icclink->memory->non_gc_memory, link_handle->clut->table,
+                           "gscms_release_link");
+            gs_free_object(icclink->memory->non_gc_memory, link_handle->clut,
+                           "gscms_release_link");
+        }
         next_handle = link_handle->next;
         gs_free_object(icclink->memory->non_gc_memory, link_handle, "gscms_release_link");
         link_handle = next_handle;
@@ -1048,6 +1439,8 @@ gscms_get_name2device_link(gsicc_link_t *icclink,
                                           sizeof(gx_color_value), sizeof(gx_color_value));
     link_handle->hTransform = hTransformNew;
     link_handle->next = NULL;
+    link_handle->clut = NULL;
+    link_handle->clut_state = -1;
     icclink->link_handle = link_handle;
 
     cmsCloseProfile(ctx, lcms_srchandle);
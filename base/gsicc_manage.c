@@ -129,6 +129,22 @@ gsicc_currentcoloraccuracy(gs_memory_t *mem)
     return ctx->icc_color_accuracy;
 }
 
+void
+gsicc_setbufferclut(gs_memory_t *mem, bool clut)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    ctx->icc_buffer_clut = clut;
+}
+
+bool
+gsicc_currentbufferclut(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return ctx->icc_buffer_clut;
+}
+
 /* Get the size of the ICC profile that is in the buffer */
 unsigned int
 gsicc_getprofilesize(unsigned char *buffer)
@@ -3116,6 +3132,68 @@ gs_seticcdirectory(const gs_gstate * pgs, gs_param_string * pval)
     return 0;
 }
 
+void
+gs_currenticclinkcachedir(const gs_gstate * pgs, gs_param_string * pval)
+{
+    const gs_lib_ctx_t *lib_ctx = pgs->memory->gs_lib_ctx;
+
+    if (lib_ctx->icc_link_cache_dir == NULL) {
+        pval->data = (const byte *)"";
+        pval->size = 0;
+        pval->persistent = true;
+    } else {
+        pval->data = (const byte *)(lib_ctx->icc_link_cache_dir);
+        pval->size = strlen(lib_ctx->icc_link_cache_dir);
+        pval->persistent = false;
+    }
+}
+
+/* The link cache directory is written to, so it can only be set before
+   file access controls are activated (i.e. from the command line). It
+   must be an absolute path, and is added to the permitted paths so that
+   the cache works with SAFER. */
+int
+gs_seticclinkcachedir(const gs_gstate * pgs, gs_param_string * pval)
+{
+    gs_memory_t *mem = (gs_memory_t *)pgs->memory;
+    const char *current = mem->gs_lib_ctx->icc_link_cache_dir;
+    char *pattern;
+    int code, len;
+    static const gs_path_control_t types[] = {
+        gs_permit_file_reading, gs_permit_file_writing, gs_permit_file_control
+    };
+    int k;
+
+    if (current == NULL ? pval->size == 0 :
+        (strlen(current) == pval->size &&
+         memcmp(current, pval->data, pval->size) == 0))
+        return 0;
+    if (gs_is_path_control_active(mem))
+        return_error(gs_error_invalidaccess);
+    /* Scratch files are only created next to the cache entries when the
+       directory is absolute. */
+    if (pval->size != 0 &&
+        !gp_file_name_is_absolute((const char *)pval->data, pval->size))
+        return_error(gs_error_rangecheck);
+    code = gs_lib_ctx_set_icc_link_cache_dir(mem, (const char *)pval->data,
+                                             pval->size);
+    if (code < 0 || pval->size == 0)
+        return code;
+
+    len = pval->size + strlen(gp_file_name_directory_separator()) + 1;
+    pattern = (char *)gs_alloc_bytes(mem, len + 1, "gs_seticclinkcachedir");
+    if (pattern == NULL)
+        return_error(gs_error_VMerror);
+    memcpy(pattern, pval->data, pval->size);
+    pattern[pval->size] = 0;
+    strcat(pattern, gp_file_name_directory_separator());
+    strcat(pattern, "*");
+    for (k = 0; k < (int)countof(types) && code >= 0; k++)
+        code = gs_add_control_path(mem, types[k], pattern);
+    gs_free_object(mem, pattern, "gs_seticclinkcachedir");
+    return code;
+}
+
 void
 gs_currentsrcgtagicc(const gs_gstate * pgs, gs_param_string * pval)
 {
@@ -148,6 +148,8 @@ void gs_currentdefaultgrayicc(const gs_gstate * pgs, gs_param_string * pval);
 int gs_setdefaultgrayicc(const gs_gstate * pgs, gs_param_string * pval);
 void gs_currenticcdirectory(const gs_gstate * pgs, gs_param_string * pval);
 int gs_seticcdirectory(const gs_gstate * pgs, gs_param_string * pval);
+void gs_currenticclinkcachedir(const gs_gstate * pgs, gs_param_string * pval);
+int gs_seticclinkcachedir(const gs_gstate * pgs, gs_param_string * pval);
 void gs_currentsrcgtagicc(const gs_gstate * pgs, gs_param_string * pval);
 int gs_setsrcgtagicc(const gs_gstate * pgs, gs_param_string * pval);
 void gs_currentdefaultrgbicc(const gs_gstate * pgs, gs_param_string * pval);
@@ -161,6 +163,8 @@ int gs_setlabicc(const gs_gstate * pgs, gs_param_string * pval);
 int gsicc_get_device_class(cmm_profile_t *icc_profile);
 uint gsicc_currentcoloraccuracy(gs_memory_t *mem);
 void gsicc_setcoloraccuracy(gs_memory_t *mem, uint level);
+bool gsicc_currentbufferclut(gs_memory_t *mem);
+void gsicc_setbufferclut(gs_memory_t *mem, bool clut);
 
 #if ICC_DUMP
 static void dump_icc_buffer(const gs_memory_t *mem, int buffersize, char filename[],byte *Buffer);
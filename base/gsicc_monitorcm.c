@@ -412,7 +412,7 @@ gsicc_mcm_end_monitor(gsicc_link_cache_t *cache, gx_device *dev)
 {
     gx_monitor_t *lock = cache->lock;
     gsicc_link_t *curr;
-    int code;
+    int code, i;
     cmm_dev_profile_t *dev_profile;
 
 
@@ -430,17 +430,21 @@ gsicc_mcm_end_monitor(gsicc_link_cache_t *cache, gx_device *dev)
 
     /* Lock the cache as we remove monitoring from the links */
     gx_monitor_enter(lock);
-    curr = cache->head;
-    while (curr != NULL ) {
-        if (curr->is_monitored) {
-            curr->procs = curr->orig_procs;
-            if (curr->hashcode.des_hash == curr->hashcode.src_hash)
-                curr->is_identity = true;
-            curr->is_monitored = false;
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        gx_monitor_enter(cache->shards[i].lock);
+        curr = cache->shards[i].head;
+        while (curr != NULL ) {
+            if (curr->is_monitored) {
+                curr->procs = curr->orig_procs;
+                if (curr->hashcode.des_hash == curr->hashcode.src_hash)
+                    curr->is_identity = true;
+                curr->is_monitored = false;
+            }
+            /* Now release any tasks/threads waiting for these contents */
+            gx_monitor_leave(curr->lock);
+            curr = curr->next;
         }
-        /* Now release any tasks/threads waiting for these contents */
-        gx_monitor_leave(curr->lock);
-        curr = curr->next;
+        gx_monitor_leave(cache->shards[i].lock);
     }
     gx_monitor_leave(lock);	/* done with updating, let everyone run */
     return 0;
@@ -454,7 +458,7 @@ gsicc_mcm_begin_monitor(gsicc_link_cache_t *cache, gx_device *dev)
 {
     gx_monitor_t *lock = cache->lock;
     gsicc_link_t *curr;
-    int code;
+    int code, i;
     cmm_dev_profile_t *dev_profile;
 
     /* Get the device profile */
@@ -472,14 +476,18 @@ gsicc_mcm_begin_monitor(gsicc_link_cache_t *cache, gx_device *dev)
     /* Lock the cache as we remove monitoring from the links */
     gx_monitor_enter(lock);
 
-    curr = cache->head;
-    while (curr != NULL ) {
-        if (curr->data_cs != gsGRAY) {
-            gsicc_mcm_set_link(curr);
-            /* Now release any tasks/threads waiting for these contents */
-            gx_monitor_leave(curr->lock);
+    for (i = 0; i < ICC_CACHE_SHARDS; i++) {
+        gx_monitor_enter(cache->shards[i].lock);
+        curr = cache->shards[i].head;
+        while (curr != NULL ) {
+            if (curr->data_cs != gsGRAY) {
+                gsicc_mcm_set_link(curr);
+                /* Now release any tasks/threads waiting for these contents */
+                gx_monitor_leave(curr->lock);
+            }
+            curr = curr->next;
         }
-        curr = curr->next;
+        gx_monitor_leave(cache->shards[i].lock);
     }
     gx_monitor_leave(lock);	/* done with updating, let everyone run */
     return 0;
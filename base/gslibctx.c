@@ -70,6 +70,9 @@ gs_lib_ctx_get_real_stdio(FILE **in, FILE **out, FILE **err)
 }
 
 #include "gslibctx.h"
+#include "gstrace.h"
+#include "gsmemrep.h"
+#include "gxbandcache.h"
 #include "gsmemory.h"
 
 /*  This sets the directory to prepend to the ICC profile names specified for
@@ -109,6 +112,31 @@ gs_lib_ctx_set_icc_directory(const gs_memory_t *mem_gc, const char* pname,
     return 0;
 }
 
+/* Sets the directory used for the on-disk ICC link cache. An empty name
+   turns the cache off. */
+int
+gs_lib_ctx_set_icc_link_cache_dir(const gs_memory_t *mem_gc, const char* pname,
+                                  int dir_namelen)
+{
+    char *result = NULL;
+    gs_lib_ctx_t *p_ctx = mem_gc->gs_lib_ctx;
+    gs_memory_t *p_ctx_mem = p_ctx->memory;
+
+    if (dir_namelen > 0) {
+        /* User param string.  Must allocate in non-gc memory */
+        result = (char*) gs_alloc_bytes(p_ctx_mem, dir_namelen+1,
+                                        "gs_lib_ctx_set_icc_link_cache_dir");
+        if (result == NULL)
+            return gs_error_VMerror;
+        memcpy(result, pname, dir_namelen);
+        result[dir_namelen] = 0;
+    }
+    gs_free_object(p_ctx_mem, p_ctx->icc_link_cache_dir,
+                   "gs_lib_ctx_set_icc_link_cache_dir");
+    p_ctx->icc_link_cache_dir = result;
+    return 0;
+}
+
 /* Sets/Gets the string containing the list of default devices we should try */
 int
 gs_lib_ctx_set_default_device_list(const gs_memory_t *mem, const char* dev_list_str,
@@ -422,8 +450,13 @@ void gs_lib_ctx_fin(gs_memory_t *mem)
     ctx_mem = ctx->memory;
 
     sjpxd_destroy(mem);
+    gs_trace_close(mem);
+    gs_memreport_close(mem);
+    gx_band_cache_free(mem);
     gs_free_object(ctx_mem, ctx->profiledir,
         "gs_lib_ctx_fin");
+    gs_free_object(ctx_mem, ctx->icc_link_cache_dir,
+        "gs_lib_ctx_fin");
 
     gs_free_object(ctx_mem, ctx->default_device_list,
                 "gs_lib_ctx_fin");
@@ -690,6 +723,36 @@ gs_remove_outputfile_control_path(gs_memory_t *mem, const char *fname)
     return gs_remove_control_path(mem, gs_permit_file_writing, f);
 }
 
+/* Permit reading, writing, renaming and deleting files in a directory which
+ * the interpreter keeps its own files in, such as -sPDFIndexCache=.
+ */
+int
+gs_add_directory_control_path(gs_memory_t *mem, const char *dirname)
+{
+    char f[gp_file_name_sizeof];
+    const char *sep = gp_file_name_directory_separator();
+    size_t len = strlen(dirname), seplen = strlen(sep);
+    int code;
+
+    if (len == 0)
+        return 0;
+    /* Be sure the string copy, separator and wildcard will fit */
+    if (len + seplen + 2 > gp_file_name_sizeof)
+        return gs_error_rangecheck;
+    strcpy(f, dirname);
+    if (len < seplen || strcmp(f + len - seplen, sep) != 0)
+        strcat(f, sep);
+    strcat(f, "*");
+
+    code = gs_add_control_path(mem, gs_permit_file_reading, f);
+    if (code < 0)
+        return code;
+    code = gs_add_control_path(mem, gs_permit_file_writing, f);
+    if (code < 0)
+        return code;
+    return gs_add_control_path(mem, gs_permit_file_control, f);
+}
+
 int
 gs_add_explicit_control_path(gs_memory_t *mem, const char *arg, gs_path_control_t control)
 {
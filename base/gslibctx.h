@@ -182,6 +182,8 @@ typedef struct gs_lib_ctx_s
     uint screen_min_screen_levels;
     /* Accuracy vs. performance for ICC color */
     uint icc_color_accuracy;
+    /* 8 bit RGB/CMYK buffers through a table sampled from the link (ICCBufferCLUT) */
+    bool icc_buffer_clut;
     /* real time clock 'bias' value. Not strictly required, but some FTS
      * tests work better if realtime starts from 0 at boot time. */
     long real_time_0[2];
@@ -194,6 +196,11 @@ typedef struct gs_lib_ctx_s
      * and one in the device */
     char *profiledir;               /* Directory used in searching for ICC profiles */
     int profiledir_len;             /* length of directory name (allows for Unicode) */
+    char *icc_link_cache_dir;       /* Directory for the on-disk ICC link cache, or NULL */
+    struct gs_trace_s *trace;       /* Performance trace output (gstrace.h), or NULL */
+    struct gs_memreport_s *memreport; /* Memory accounting report (gsmemrep.h), or NULL */
+    bool band_list_fast_compression; /* BandListCompression=fast: see gxclmem.c */
+    struct gx_band_cache_s *band_cache; /* BandCacheSize: see gxbandcache.h */
     gs_fapi_server **fapi_servers;
     char *default_device_list;
     int gcsignal;
@@ -234,6 +241,9 @@ int gs_lib_ctx_nts_adjust(gs_memory_t *mem, int adjust);
 int gs_lib_ctx_set_icc_directory(const gs_memory_t *mem_gc, const char* pname,
                                  int dir_namelen);
 
+int gs_lib_ctx_set_icc_link_cache_dir(const gs_memory_t *mem_gc, const char* pname,
+                                      int dir_namelen);
+
 
 /* Sets/Gets the string containing the list of device names we should search
  * to find a suitable default
@@ -287,6 +297,9 @@ gs_add_outputfile_control_path(gs_memory_t *mem, const char *fname);
 int
 gs_remove_outputfile_control_path(gs_memory_t *mem, const char *fname);
 
+int
+gs_add_directory_control_path(gs_memory_t *mem, const char *dirname);
+
 int
 gs_add_explicit_control_path(gs_memory_t *mem, const char *arg, gs_path_control_t control);
 
@@ -960,6 +960,8 @@ chunk_obj_alloc(gs_memory_t *mem, size_t size, gs_memory_type_ptr_t type, client
     }
 
     cmem->used += newsize;
+    if (cmem->used > cmem->max_used)
+        cmem->max_used = cmem->used;
     obj->size = newsize; /* actual size */
     obj->padding = newsize - size; /* actual size - client requested size */
     obj->type = type;    /* and client desired type */
@@ -0,0 +1,444 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Memory accounting report (-sMemoryReportFile=) */
+
+#include "memory_.h"
+#include "gx.h"
+#include "gserrors.h"
+#include "gp.h"
+#include "gpsync.h"
+#include "gxsync.h"
+#include "gslibctx.h"
+#include "gsmemrep.h"
+
+/*
+ * The output is a JSON object:
+ *
+ *   {"pages":[ {one record per page}, ... ],
+ *    "recommendation":{ ... }}
+ *
+ * The page figures are for the time from the end of the previous page to
+ * the end of this one, so with BGPrint the rendering of one page is
+ * reported with the next.
+ *
+ * The recommendation is worked out from a simple model of what banding
+ * costs, fitted to what was seen:
+ *
+ *  - each band buffer (the main one, and one per rendering thread slot)
+ *    needs BandHeight lines of raster, plus the tile cache;
+ *  - each line being rendered needs 'pdf14_per_line' bytes for the
+ *    transparency buffers (the largest pdf14 peak of any page, divided by
+ *    the number of lines that were being rendered at once);
+ *  - each rendering thread slot needs a fixed amount more (halftone and
+ *    ICC caches, paths and so on): the most a thread allocated less its
+ *    band buffer and its share of the pdf14 peak;
+ *  - everything else (the interpreter, fonts, the clist itself when it is
+ *    kept in memory) is the 'base', the heap peak less the largest
+ *    banding cost of any page.
+ *
+ * The largest number of threads (no more than were used) is chosen whose
+ * band buffers, at a sensible band height, fit in the budget with the base,
+ * then the largest band height for that number of threads. The budget is
+ * the -K limit if there is one, otherwise the heap peak of this run, so
+ * that running the same job with the recommendation uses no more memory,
+ * with the space used in the most useful way.
+ */
+
+/* Threads beyond this on a page are counted but not listed */
+#define MEMREPORT_MAX_THREADS 64
+
+/* The smallest band heights worth recommending with and without threads */
+#define MEMREPORT_MIN_THREAD_BAND 64
+#define MEMREPORT_MIN_BAND 16
+
+struct gs_memreport_s {
+    gs_memory_t *memory;
+    gx_monitor_t *lock;
+    gp_file *file;
+    int num_pages;
+    /* The current page */
+    bool clist;
+    int nbands;
+    int band_height;
+    size_t band_buffer_space;
+    size_t tile_cache_size;
+    int64_t *band_bytes;
+    int band_bytes_size;
+    int64_t shared_bytes;
+    int64_t pdf14_live;
+    int64_t pdf14_peak;
+    size_t cache_used[2];
+    size_t cache_peak[2];
+    int num_workers;
+    int num_threads;
+    size_t thread_used[MEMREPORT_MAX_THREADS];
+    /* The whole job, for the recommendation */
+    size_t max_raster;
+    int max_height;
+    double pdf14_per_line;
+    int64_t thread_fixed;
+    size_t max_tile_cache;
+    int64_t max_render_cost;
+    int max_workers;
+    int max_slots_per_worker;
+    size_t max_cache_peak[2];
+    int64_t max_pdf14_peak;
+};
+
+static gs_memreport_t *
+memreport_get(const gs_memory_t *mem)
+{
+    if (mem == NULL || mem->gs_lib_ctx == NULL)
+        return NULL;
+    return mem->gs_lib_ctx->memreport;
+}
+
+int
+gs_memreport_open(gs_memory_t *mem, const char *fname)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gs_memory_t *cmem = ctx->memory;
+    gs_memreport_t *report;
+
+    gs_memreport_close(mem);
+
+    report = (gs_memreport_t *)gs_alloc_bytes(cmem, sizeof(*report), "gs_memreport_open");
+    if (report == NULL)
+        return_error(gs_error_VMerror);
+    memset(report, 0x00, sizeof(*report));
+    report->memory = cmem;
+    report->lock = gx_monitor_label(gx_monitor_alloc(cmem), "gs_memreport");
+    if (report->lock == NULL) {
+        gs_free_object(cmem, report, "gs_memreport_open");
+        return_error(gs_error_VMerror);
+    }
+    report->file = gp_fopen(cmem, fname, "w");
+    if (report->file == NULL) {
+        emprintf1(cmem, "Could not open the memory report file '%s'.\n", fname);
+        gx_monitor_free(report->lock);
+        gs_free_object(cmem, report, "gs_memreport_open");
+        return_error(gs_error_invalidfileaccess);
+    }
+    gp_fputs("{\"pages\":[", report->file);
+
+    ctx->memreport = report;
+    return 0;
+}
+
+/* Work out the recommended banding and write it out. */
+static void
+memreport_recommend(gs_memreport_t *report)
+{
+    gs_memory_status_t status;
+    int64_t budget, base, avail, line, pdfl, tile, fixed, page_cost;
+    int64_t band_buf, cost = 0;
+    int spw = max(report->max_slots_per_worker, 1);
+    int workers, slots, band_height = 0, height = report->max_height;
+    size_t max_bitmap = 0;
+    bool limited, fits = false;
+
+    gs_memory_status(report->memory->non_gc_memory, &status);
+    limited = status.limit != 0 && status.limit < max_size_t;
+    budget = limited ? (int64_t)status.limit : (int64_t)status.max_used;
+    base = (int64_t)status.max_used - report->max_render_cost;
+    if (base < 0)
+        base = 0;
+    avail = budget - base;
+
+    line = (int64_t)report->max_raster + sizeof(byte *);
+    pdfl = (int64_t)(report->pdf14_per_line + 0.5);
+    tile = report->max_tile_cache;
+    fixed = report->thread_fixed;
+
+    /* Threads are only recommended when the job used them, since
+     * otherwise we have no idea what their fixed overhead is. */
+    for (workers = report->max_workers; workers >= 0 && height > 0; workers--) {
+        int min_band = min(height, workers ? MEMREPORT_MIN_THREAD_BAND : MEMREPORT_MIN_BAND);
+        int64_t per_line, fixed_cost, lines;
+
+        slots = workers * spw;
+        per_line = line * (1 + slots) + pdfl * max(slots, 1);
+        fixed_cost = tile * (1 + slots) + fixed * slots;
+        if (avail <= fixed_cost)
+            continue;
+        lines = (avail - fixed_cost) / per_line;
+        if (lines > height)
+            lines = height;
+        if (lines < min_band)
+            continue;
+        if (lines > MEMREPORT_MIN_BAND && lines < height)
+            lines &= ~(int64_t)(MEMREPORT_MIN_BAND - 1);
+        band_height = (int)lines;
+        cost = fixed_cost + per_line * lines;
+        fits = true;
+        break;
+    }
+    if (!fits) {
+        workers = slots = 0;
+        band_height = min(max(height, 1), MEMREPORT_MIN_BAND);
+        cost = tile + (line + pdfl) * band_height;
+    }
+    band_buf = line * band_height + tile;
+    /* Round the band buffer up to 4K, the band data must be smaller */
+    band_buf = (band_buf + 4096) & ~(int64_t)4095;
+
+    /* If a whole page fits without threads, render it unbanded */
+    page_cost = (line + pdfl) * height;
+    if (workers == 0 && base + page_cost <= budget) {
+        max_bitmap = (size_t)page_cost + 1;
+        cost = page_cost;
+    }
+
+    gp_fprintf(report->file, "],\n\"recommendation\":{\"budget\":%"PRId64",\"budget_from\":\"%s\","
+               "\"heap_max_used\":%"PRIdSIZE",\"base\":%"PRId64",\"pdf14_per_line\":%"PRId64","
+               "\"thread_overhead\":%"PRId64",\"pattern_cache_peak\":%"PRIdSIZE","
+               "\"font_cache_peak\":%"PRIdSIZE",\"pdf14_peak\":%"PRId64",\n",
+               budget, limited ? "-K" : "observed", status.max_used, base, pdfl, fixed,
+               report->max_cache_peak[gs_memreport_pattern_cache],
+               report->max_cache_peak[gs_memreport_font_cache], report->max_pdf14_peak);
+    gp_fprintf(report->file, "\"fits\":%s,\"estimated_peak\":%"PRId64",\"MaxBitmap\":%"PRIdSIZE","
+               "\"BandHeight\":%d,\"BandBufferSpace\":%"PRId64",\"NumRenderingThreads\":%d,\n"
+               "\"options\":\"-dMaxBitmap=%"PRIdSIZE" -dBandHeight=%d -dBandBufferSpace=%"PRId64
+               " -dNumRenderingThreads=%d\"}}\n",
+               fits ? "true" : "false", base + cost, max_bitmap, band_height, band_buf, workers,
+               max_bitmap, band_height, band_buf, workers);
+}
+
+void
+gs_memreport_close(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gs_memreport_t *report = ctx->memreport;
+
+    if (report == NULL)
+        return;
+    ctx->memreport = NULL;
+    memreport_recommend(report);
+    gp_fclose(report->file);
+    gx_monitor_free(report->lock);
+    gs_free_object(report->memory, report->band_bytes, "gs_memreport_close");
+    gs_free_object(report->memory, report, "gs_memreport_close");
+}
+
+void
+gs_memreport_clist_band(const gs_memory_t *mem, int band_min, int band_max,
+                        int nbands, int64_t bytes)
+{
+    gs_memreport_t *report = memreport_get(mem);
+
+    if (report == NULL)
+        return;
+    gx_monitor_enter(report->lock);
+    if (nbands > report->band_bytes_size) {
+        int64_t *bb = (int64_t *)gs_alloc_byte_array(report->memory, nbands, sizeof(int64_t),
+                                                     "gs_memreport_clist_band");
+
+        if (bb != NULL) {
+            memset(bb, 0, nbands * sizeof(int64_t));
+            if (report->band_bytes != NULL)
+                memcpy(bb, report->band_bytes, report->band_bytes_size * sizeof(int64_t));
+            gs_free_object(report->memory, report->band_bytes, "gs_memreport_clist_band");
+            report->band_bytes = bb;
+            report->band_bytes_size = nbands;
+        }
+    }
+    if (band_min == band_max && band_min >= 0 && band_min < report->band_bytes_size)
+        report->band_bytes[band_min] += bytes;
+    else
+        report->shared_bytes += bytes;
+    gx_monitor_leave(report->lock);
+}
+
+void
+gs_memreport_clist_page(const gs_memory_t *mem, int nbands, int band_height,
+                        size_t band_buffer_space, size_t tile_cache_size)
+{
+    gs_memreport_t *report = memreport_get(mem);
+
+    if (report == NULL)
+        return;
+    gx_monitor_enter(report->lock);
+    report->clist = true;
+    report->nbands = nbands;
+    report->band_height = band_height;
+    report->band_buffer_space = band_buffer_space;
+    report->tile_cache_size = tile_cache_size;
+    gx_monitor_leave(report->lock);
+}
+
+void
+gs_memreport_pdf14(const gs_memory_t *mem, int64_t delta)
+{
+    gs_memreport_t *report = memreport_get(mem);
+
+    if (report == NULL)
+        return;
+    gx_monitor_enter(report->lock);
+    report->pdf14_live += delta;
+    if (report->pdf14_live > report->pdf14_peak)
+        report->pdf14_peak = report->pdf14_live;
+    gx_monitor_leave(report->lock);
+}
+
+void
+gs_memreport_cache(const gs_memory_t *mem, gs_memreport_cache_t which, size_t used)
+{
+    gs_memreport_t *report = memreport_get(mem);
+
+    if (report == NULL)
+        return;
+    gx_monitor_enter(report->lock);
+    report->cache_used[which] = used;
+    if (used > report->cache_peak[which])
+        report->cache_peak[which] = used;
+    gx_monitor_leave(report->lock);
+}
+
+void
+gs_memreport_render_thread(const gs_memory_t *mem, int num_workers, size_t max_used)
+{
+    gs_memreport_t *report = memreport_get(mem);
+
+    if (report == NULL)
+        return;
+    gx_monitor_enter(report->lock);
+    report->num_workers = num_workers;
+    if (report->num_threads < MEMREPORT_MAX_THREADS)
+        report->thread_used[report->num_threads] = max_used;
+    report->num_threads++;
+    gx_monitor_leave(report->lock);
+}
+
+/* Fold the current page into the figures for the recommendation. */
+static void
+memreport_fit(gs_memreport_t *report, int height, size_t raster)
+{
+    int slots = report->num_threads;
+    int listed = min(slots, MEMREPORT_MAX_THREADS);
+    int64_t cost;
+    double pdfl;
+    int i;
+
+    if (raster > report->max_raster)
+        report->max_raster = raster;
+    if (height > report->max_height)
+        report->max_height = height;
+    if (report->pdf14_peak > report->max_pdf14_peak)
+        report->max_pdf14_peak = report->pdf14_peak;
+
+    if (report->clist && report->band_height > 0) {
+        int64_t band_lines = (int64_t)report->band_height * max(slots, 1);
+
+        pdfl = (double)report->pdf14_peak / band_lines;
+        cost = report->band_buffer_space;
+        if (slots == 0)
+            cost += report->pdf14_peak;
+        /* A thread's band buffer is sized for the band, not BandBufferSpace */
+        for (i = 0; i < listed; i++) {
+            int64_t fixed = (int64_t)report->thread_used[i] - report->tile_cache_size -
+                            (int64_t)((raster + sizeof(byte *) + pdfl) * report->band_height);
+
+            cost += report->thread_used[i];
+            if (fixed > report->thread_fixed)
+                report->thread_fixed = fixed;
+        }
+        if (report->tile_cache_size > report->max_tile_cache)
+            report->max_tile_cache = report->tile_cache_size;
+        if (report->num_workers > 0) {
+            int spw = (slots + report->num_workers - 1) / report->num_workers;
+
+            if (report->num_workers > report->max_workers)
+                report->max_workers = report->num_workers;
+            if (spw > report->max_slots_per_worker)
+                report->max_slots_per_worker = spw;
+        }
+    } else {
+        pdfl = height > 0 ? (double)report->pdf14_peak / height : 0;
+        cost = (int64_t)(raster + sizeof(byte *)) * height + report->pdf14_peak;
+    }
+    if (pdfl > report->pdf14_per_line)
+        report->pdf14_per_line = pdfl;
+    if (cost > report->max_render_cost)
+        report->max_render_cost = cost;
+}
+
+void
+gs_memreport_page(const gs_memory_t *mem, int64_t page, int width, int height,
+                  size_t raster)
+{
+    gs_memreport_t *report = memreport_get(mem);
+    gs_memory_status_t status;
+    gp_file *f;
+    int i;
+
+    if (report == NULL)
+        return;
+    gs_memory_status(report->memory->non_gc_memory, &status);
+    f = report->file;
+
+    gx_monitor_enter(report->lock);
+    gp_fprintf(f, "%s\n{\"page\":%"PRId64",\"width\":%d,\"height\":%d,\"raster\":%"PRIdSIZE",\n",
+               report->num_pages ? "," : "", page, width, height, raster);
+    if (report->clist) {
+        int64_t total = report->shared_bytes, largest = 0;
+        int n = min(report->nbands, report->band_bytes_size);
+
+        for (i = 0; i < n; i++) {
+            total += report->band_bytes[i];
+            if (report->band_bytes[i] > largest)
+                largest = report->band_bytes[i];
+        }
+        gp_fprintf(f, " \"clist\":{\"bands\":%d,\"band_height\":%d,\"band_buffer_space\":%"PRIdSIZE","
+                   "\"tile_cache_size\":%"PRIdSIZE",\"bytes\":%"PRId64",\"shared_bytes\":%"PRId64","
+                   "\"max_band_bytes\":%"PRId64",\n  \"band_bytes\":[",
+                   report->nbands, report->band_height, report->band_buffer_space,
+                   report->tile_cache_size, total, report->shared_bytes, largest);
+        for (i = 0; i < n; i++)
+            gp_fprintf(f, "%s%"PRId64, i ? "," : "", report->band_bytes[i]);
+        gp_fputs("]},\n", f);
+    } else
+        gp_fputs(" \"clist\":null,\n", f);
+    gp_fprintf(f, " \"pdf14_peak\":%"PRId64",\"pattern_cache_peak\":%"PRIdSIZE",\"font_cache_peak\":%"PRIdSIZE",\n",
+               report->pdf14_peak, report->cache_peak[gs_memreport_pattern_cache],
+               report->cache_peak[gs_memreport_font_cache]);
+    gp_fprintf(f, " \"render_threads\":{\"workers\":%d,\"slots\":%d,\"max_used\":[",
+               report->num_workers, report->num_threads);
+    for (i = 0; i < min(report->num_threads, MEMREPORT_MAX_THREADS); i++)
+        gp_fprintf(f, "%s%"PRIdSIZE, i ? "," : "", report->thread_used[i]);
+    gp_fprintf(f, "]},\n \"heap_used\":%"PRIdSIZE",\"heap_max_used\":%"PRIdSIZE"}",
+               status.used, status.max_used);
+
+    memreport_fit(report, height, raster);
+    for (i = 0; i < 2; i++) {
+        if (report->cache_peak[i] > report->max_cache_peak[i])
+            report->max_cache_peak[i] = report->cache_peak[i];
+        report->cache_peak[i] = report->cache_used[i];
+    }
+
+    /* Start the next page */
+    report->num_pages++;
+    report->clist = false;
+    report->nbands = 0;
+    report->band_height = 0;
+    report->shared_bytes = 0;
+    if (report->band_bytes != NULL)
+        memset(report->band_bytes, 0, report->band_bytes_size * sizeof(int64_t));
+    report->pdf14_peak = report->pdf14_live;
+    report->num_workers = 0;
+    report->num_threads = 0;
+    gx_monitor_leave(report->lock);
+}
@@ -0,0 +1,77 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Memory accounting report (-sMemoryReportFile=) */
+
+#ifndef gsmemrep_INCLUDED
+#  define gsmemrep_INCLUDED
+
+#include "std.h"
+#include "stdint_.h"
+
+/*
+ * When a memory report file is open (-sMemoryReportFile=) the places
+ * which use most of the memory when rendering a page tell this module
+ * how much they are using, and a JSON record is written for each page:
+ * the clist bytes written for each band, the peak of the pdf14
+ * transparency buffers, the pattern and font cache high-water marks and
+ * what each rendering thread allocated. When the file is closed a
+ * recommended MaxBitmap, BandHeight, BandBufferSpace and
+ * NumRenderingThreads is added, for the -K limit if one was given, or
+ * for the peak that was seen otherwise.
+ *
+ * All the functions do nothing (after one test) when no report is open,
+ * and may be called from any thread.
+ */
+
+typedef struct gs_memreport_s gs_memreport_t;
+
+typedef enum {
+    gs_memreport_pattern_cache,
+    gs_memreport_font_cache
+} gs_memreport_cache_t;
+
+/* Open the report file for the library instance of 'mem'. */
+int gs_memreport_open(gs_memory_t *mem, const char *fname);
+
+/* Write the recommendation and close the report file, if there is one. */
+void gs_memreport_close(gs_memory_t *mem);
+
+/* 'bytes' of page clist data were written for bands band_min..band_max. */
+void gs_memreport_clist_band(const gs_memory_t *mem, int band_min, int band_max,
+                             int nbands, int64_t bytes);
+
+/* The page clist was finished, with these band parameters. */
+void gs_memreport_clist_page(const gs_memory_t *mem, int nbands, int band_height,
+                             size_t band_buffer_space, size_t tile_cache_size);
+
+/* pdf14 buffer data was allocated (delta > 0) or freed (delta < 0). */
+void gs_memreport_pdf14(const gs_memory_t *mem, int64_t delta);
+
+/* A cache is now using 'used' bytes. */
+void gs_memreport_cache(const gs_memory_t *mem, gs_memreport_cache_t which,
+                        size_t used);
+
+/* A clist rendering thread (one of 'num_workers') allocated at most
+ * 'max_used' bytes. */
+void gs_memreport_render_thread(const gs_memory_t *mem, int num_workers,
+                                size_t max_used);
+
+/* Page 'page' has been output: write its record. */
+void gs_memreport_page(const gs_memory_t *mem, int64_t page, int width,
+                       int height, size_t raster);
+
+#endif /* gsmemrep_INCLUDED */
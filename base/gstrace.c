@@ -0,0 +1,192 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Performance trace output (-sTraceFile=) */
+
+#include "memory_.h"
+#include "gx.h"
+#include "gserrors.h"
+#include "gp.h"
+#include "gpsync.h"
+#include "gxsync.h"
+#include "gslibctx.h"
+#include "gstrace.h"
+
+/*
+ * The output is the JSON array form of the Chrome trace event format, with
+ * one "complete" (ph:X) event per span. Times are in microseconds from when
+ * the file was opened. Threads are numbered in the order they first record
+ * a span, starting from the one which opened the file, and given names so
+ * the lanes are labelled in the viewer.
+ */
+
+/* Threads beyond this all share the last lane */
+#define TRACE_MAX_LANES 64
+
+struct gs_trace_s {
+    gs_memory_t *memory;
+    gx_monitor_t *lock;
+    gp_file *file;
+    long t0[2];
+    int64_t mark;
+    int num_lanes;
+    gp_thread_id lanes[TRACE_MAX_LANES];
+};
+
+static int64_t
+trace_now(const gs_trace_t *trace)
+{
+    long now[2];
+
+    gp_get_realtime(now);
+    return (int64_t)(now[0] - trace->t0[0]) * 1000000 +
+           (now[1] - trace->t0[1]) / 1000;
+}
+
+/* Find (or assign) the lane for the calling thread. Called with the lock held. */
+static int
+trace_lane(gs_trace_t *trace)
+{
+    gp_thread_id self = gp_thread_self();
+    int i;
+
+    for (i = 0; i < trace->num_lanes; i++) {
+        if (trace->lanes[i] == self)
+            return i;
+    }
+    if (trace->num_lanes == TRACE_MAX_LANES)
+        return TRACE_MAX_LANES - 1;
+
+    trace->lanes[i] = self;
+    trace->num_lanes++;
+    if (i == 0)
+        gp_fprintf(trace->file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                   "\"args\":{\"name\":\"main\"}}");
+    else
+        gp_fprintf(trace->file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"name\":\"thread %d\"}}", i, i);
+    return i;
+}
+
+int
+gs_trace_open(gs_memory_t *mem, const char *fname)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gs_memory_t *cmem = ctx->memory;
+    gs_trace_t *trace;
+
+    gs_trace_close(mem);
+
+    trace = (gs_trace_t *)gs_alloc_bytes(cmem, sizeof(*trace), "gs_trace_open");
+    if (trace == NULL)
+        return_error(gs_error_VMerror);
+    memset(trace, 0x00, sizeof(*trace));
+    trace->memory = cmem;
+    trace->lock = gx_monitor_label(gx_monitor_alloc(cmem), "gs_trace");
+    if (trace->lock == NULL) {
+        gs_free_object(cmem, trace, "gs_trace_open");
+        return_error(gs_error_VMerror);
+    }
+    trace->file = gp_fopen(cmem, fname, "w");
+    if (trace->file == NULL) {
+        emprintf1(cmem, "Could not open the trace file '%s'.\n", fname);
+        gx_monitor_free(trace->lock);
+        gs_free_object(cmem, trace, "gs_trace_open");
+        return_error(gs_error_invalidfileaccess);
+    }
+    gp_get_realtime(trace->t0);
+    gp_fputs("[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+             "\"args\":{\"name\":\"Ghostscript\"}}", trace->file);
+    (void)trace_lane(trace);
+
+    ctx->trace = trace;
+    return 0;
+}
+
+void
+gs_trace_close(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gs_trace_t *trace = ctx->trace;
+
+    if (trace == NULL)
+        return;
+    ctx->trace = NULL;
+    gp_fputs("\n]\n", trace->file);
+    gp_fclose(trace->file);
+    gx_monitor_free(trace->lock);
+    gs_free_object(trace->memory, trace, "gs_trace_close");
+}
+
+int64_t
+gs_trace_mark(const gs_memory_t *mem)
+{
+    gs_trace_t *trace;
+    int64_t now, prev;
+
+    if (mem == NULL || mem->gs_lib_ctx == NULL)
+        return -1;
+    trace = mem->gs_lib_ctx->trace;
+    if (trace == NULL)
+        return -1;
+    now = trace_now(trace);
+    gx_monitor_enter(trace->lock);
+    prev = trace->mark;
+    trace->mark = now;
+    gx_monitor_leave(trace->lock);
+    return prev;
+}
+
+int64_t
+gs_trace_begin(const gs_memory_t *mem)
+{
+    gs_trace_t *trace;
+
+    if (mem == NULL || mem->gs_lib_ctx == NULL)
+        return -1;
+    trace = mem->gs_lib_ctx->trace;
+    if (trace == NULL)
+        return -1;
+    return trace_now(trace);
+}
+
+void
+gs_trace_end(const gs_memory_t *mem, int64_t start, const char *cat,
+             const char *name, int64_t arg)
+{
+    gs_trace_t *trace;
+    int64_t end;
+    int lane;
+
+    if (start < 0 || mem == NULL || mem->gs_lib_ctx == NULL)
+        return;
+    trace = mem->gs_lib_ctx->trace;
+    if (trace == NULL)
+        return;
+    end = trace_now(trace);
+
+    gx_monitor_enter(trace->lock);
+    lane = trace_lane(trace);
+    if (arg >= 0)
+        gp_fprintf(trace->file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                   "\"ts\":%"PRId64",\"dur\":%"PRId64",\"args\":{\"n\":%"PRId64"}}",
+                   name, cat, lane, start, end - start, arg);
+    else
+        gp_fprintf(trace->file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                   "\"ts\":%"PRId64",\"dur\":%"PRId64"}",
+                   name, cat, lane, start, end - start);
+    gx_monitor_leave(trace->lock);
+}
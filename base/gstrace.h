@@ -0,0 +1,59 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Performance trace output (-sTraceFile=) */
+
+#ifndef gstrace_INCLUDED
+#  define gstrace_INCLUDED
+
+#include "std.h"
+#include "stdint_.h"
+
+/*
+ * When a trace file is open (-sTraceFile=) timed spans are
+ * written to it as Chrome trace events, which can be loaded into
+ * chrome://tracing or https://ui.perfetto.dev. Each thread which records a
+ * span gets its own lane. A span is recorded with:
+ *
+ *     int64_t start = gs_trace_begin(mem);
+ *     ...
+ *     gs_trace_end(mem, start, "category", "name", arg);
+ *
+ * gs_trace_begin returns -1 when no trace file is open, and gs_trace_end
+ * does nothing with a start of -1, so the cost when tracing is off is one
+ * test. 'arg' is shown with the span (a page or band number, a byte count);
+ * pass -1 for none. The category and name must be string constants, they
+ * are written as they are, without quoting.
+ */
+
+typedef struct gs_trace_s gs_trace_t;
+
+/* Open the trace file for the library instance of 'mem'. */
+int gs_trace_open(gs_memory_t *mem, const char *fname);
+
+/* Finish and close the trace file, if there is one. */
+void gs_trace_close(gs_memory_t *mem);
+
+int64_t gs_trace_begin(const gs_memory_t *mem);
+void gs_trace_end(const gs_memory_t *mem, int64_t start, const char *cat,
+                  const char *name, int64_t arg);
+
+/* Set the mark to the current time and return the previous one (initially
+ * the time the file was opened), for spans such as page interpretation
+ * which start in one place and end in another. -1 when tracing is off. */
+int64_t gs_trace_mark(const gs_memory_t *mem);
+
+#endif /* gstrace_INCLUDED */
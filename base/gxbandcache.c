@@ -0,0 +1,261 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Cache of rendered bands (BandCacheSize user parameter) */
+
+#include "memory_.h"
+#include "gx.h"
+#include "gserrors.h"
+#include "gxdevmem.h"
+#include "gxsync.h"
+#include "gslibctx.h"
+#include "gxbandcache.h"
+
+/*
+ * The number of bands which fit in any sensible BandCacheSize is small
+ * (a few hundred at most), so the entries are kept in one list, most
+ * recently used first, and searched linearly. The digest is compared
+ * first, so a search is mostly one 16 byte compare per entry.
+ */
+
+typedef struct gx_band_cache_entry_s gx_band_cache_entry_t;
+struct gx_band_cache_entry_s {
+    gx_band_cache_entry_t *next, *prev;
+    gx_band_cache_key_t key;
+    size_t size;
+    byte *data;			/* the planes one after another */
+};
+
+struct gx_band_cache_s {
+    gs_memory_t *memory;
+    gx_monitor_t *lock;
+    int64_t max_size;
+    int64_t size;
+    gx_band_cache_entry_t *head, *tail;
+};
+
+static size_t
+band_cache_data_size(const gx_band_cache_key_t *key)
+{
+    return (size_t)key->raster * key->height * key->num_planes;
+}
+
+/* Is mdev laid out the way the key says? */
+static bool
+band_cache_key_fits(const gx_band_cache_key_t *key, const gx_device_memory *mdev)
+{
+    int num_planes = mdev->num_planar_planes ? mdev->num_planar_planes : 1;
+
+    return mdev->width == key->width && mdev->height == key->height &&
+           mdev->raster == key->raster && num_planes == key->num_planes &&
+           mdev->line_ptrs != NULL;
+}
+
+static void
+band_cache_unlink(gx_band_cache_t *cache, gx_band_cache_entry_t *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        cache->head = e->next;
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        cache->tail = e->prev;
+    e->next = e->prev = NULL;
+}
+
+static void
+band_cache_push(gx_band_cache_t *cache, gx_band_cache_entry_t *e)
+{
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head)
+        cache->head->prev = e;
+    else
+        cache->tail = e;
+    cache->head = e;
+}
+
+static void
+band_cache_drop(gx_band_cache_t *cache, gx_band_cache_entry_t *e)
+{
+    band_cache_unlink(cache, e);
+    cache->size -= e->size;
+    gs_free_object(cache->memory, e->data, "band_cache_drop(data)");
+    gs_free_object(cache->memory, e, "band_cache_drop");
+}
+
+/* Drop the least recently used entries until 'extra' more bytes fit. */
+static void
+band_cache_trim(gx_band_cache_t *cache, int64_t extra)
+{
+    while (cache->tail != NULL && cache->size + extra > cache->max_size)
+        band_cache_drop(cache, cache->tail);
+}
+
+static gx_band_cache_entry_t *
+band_cache_find(gx_band_cache_t *cache, const gx_band_cache_key_t *key)
+{
+    gx_band_cache_entry_t *e;
+
+    for (e = cache->head; e != NULL; e = e->next) {
+        if (memcmp(e->key.digest, key->digest, sizeof(key->digest)) == 0 &&
+            memcmp(&e->key, key, sizeof(*key)) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+int
+gx_band_cache_set_size(gs_memory_t *mem, int64_t size)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gx_band_cache_t *cache = ctx->band_cache;
+
+    if (size < 0)
+        return_error(gs_error_rangecheck);
+    if (cache == NULL) {
+        gs_memory_t *cmem = ctx->memory;
+
+        if (size == 0)
+            return 0;
+        cache = (gx_band_cache_t *)gs_alloc_bytes(cmem, sizeof(*cache),
+                                                  "gx_band_cache_set_size");
+        if (cache == NULL)
+            return_error(gs_error_VMerror);
+        memset(cache, 0x00, sizeof(*cache));
+        cache->memory = cmem;
+        cache->lock = gx_monitor_label(gx_monitor_alloc(cmem), "band_cache");
+        if (cache->lock == NULL) {
+            gs_free_object(cmem, cache, "gx_band_cache_set_size");
+            return_error(gs_error_VMerror);
+        }
+        ctx->band_cache = cache;
+    }
+    /* The cache itself stays until the instance is finished, even at size
+     * 0, since rendering threads (background printing) may be using it. */
+    gx_monitor_enter(cache->lock);
+    cache->max_size = size;
+    band_cache_trim(cache, 0);
+    gx_monitor_leave(cache->lock);
+    return 0;
+}
+
+int64_t
+gx_band_cache_size(const gs_memory_t *mem)
+{
+    gx_band_cache_t *cache = mem->gs_lib_ctx->band_cache;
+
+    return cache == NULL ? 0 : cache->max_size;
+}
+
+bool
+gx_band_cache_enabled(const gs_memory_t *mem)
+{
+    gx_band_cache_t *cache;
+
+    if (mem == NULL || mem->gs_lib_ctx == NULL)
+        return false;
+    cache = mem->gs_lib_ctx->band_cache;
+    return cache != NULL && cache->max_size > 0;
+}
+
+int
+gx_band_cache_get(const gs_memory_t *mem, const gx_band_cache_key_t *key,
+                  gx_device_memory *mdev)
+{
+    gx_band_cache_t *cache = mem->gs_lib_ctx->band_cache;
+    gx_band_cache_entry_t *e;
+    int found = 0;
+
+    if (cache == NULL || !band_cache_key_fits(key, mdev))
+        return 0;
+    gx_monitor_enter(cache->lock);
+    e = band_cache_find(cache, key);
+    if (e != NULL) {
+        const byte *src = e->data;
+        int y, n = key->height * key->num_planes;
+
+        /* Line pointers are per plane, height of them for each. */
+        for (y = 0; y < n; y++, src += key->raster)
+            memcpy(mdev->line_ptrs[y], src, key->raster);
+        band_cache_unlink(cache, e);
+        band_cache_push(cache, e);
+        found = 1;
+    }
+    gx_monitor_leave(cache->lock);
+    return found;
+}
+
+void
+gx_band_cache_put(const gs_memory_t *mem, const gx_band_cache_key_t *key,
+                  const gx_device_memory *mdev)
+{
+    gx_band_cache_t *cache = mem->gs_lib_ctx->band_cache;
+    size_t size = band_cache_data_size(key);
+    gx_band_cache_entry_t *e;
+    byte *dst;
+    int y, n = key->height * key->num_planes;
+
+    if (cache == NULL || !band_cache_key_fits(key, mdev) ||
+        size == 0 || (int64_t)size > cache->max_size)
+        return;
+
+    /* Copy outside the lock; the entry is private until it is linked in. */
+    e = (gx_band_cache_entry_t *)gs_alloc_bytes(cache->memory, sizeof(*e),
+                                                "gx_band_cache_put");
+    if (e == NULL)
+        return;
+    e->data = gs_alloc_bytes(cache->memory, size, "gx_band_cache_put(data)");
+    if (e->data == NULL) {
+        gs_free_object(cache->memory, e, "gx_band_cache_put");
+        return;
+    }
+    e->key = *key;
+    e->size = size;
+    e->next = e->prev = NULL;
+    for (y = 0, dst = e->data; y < n; y++, dst += key->raster)
+        memcpy(dst, mdev->line_ptrs[y], key->raster);
+
+    gx_monitor_enter(cache->lock);
+    if ((int64_t)size > cache->max_size || band_cache_find(cache, key) != NULL) {
+        /* Size changed, or another thread got there first */
+        gx_monitor_leave(cache->lock);
+        gs_free_object(cache->memory, e->data, "gx_band_cache_put(data)");
+        gs_free_object(cache->memory, e, "gx_band_cache_put");
+        return;
+    }
+    band_cache_trim(cache, size);
+    band_cache_push(cache, e);
+    cache->size += size;
+    gx_monitor_leave(cache->lock);
+}
+
+void
+gx_band_cache_free(gs_memory_t *mem)
+{
+    gs_lib_ctx_t *ctx = mem->gs_lib_ctx;
+    gx_band_cache_t *cache = ctx->band_cache;
+
+    if (cache == NULL)
+        return;
+    ctx->band_cache = NULL;
+    while (cache->head != NULL)
+        band_cache_drop(cache, cache->head);
+    gx_monitor_free(cache->lock);
+    gs_free_object(cache->memory, cache, "gx_band_cache_free");
+}
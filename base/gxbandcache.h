@@ -0,0 +1,89 @@
+/* Copyright (C) 2026 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  39 Mesa Street, Suite 108A, San Francisco,
+   CA 94129, USA, for further information.
+*/
+
+
+/* Cache of rendered bands (BandCacheSize user parameter) */
+
+#ifndef gxbandcache_INCLUDED
+#  define gxbandcache_INCLUDED
+
+#include "gxdevcli.h"
+#include "gscms.h"
+
+/*
+ * When a job produces pages whose bands have exactly the same commands
+ * (letterheads, footers, blank areas), the clist reader renders such a band
+ * once and copies the result for the others. The cache belongs to the
+ * library instance, so it is shared by all pages and all rendering
+ * threads, and entries are dropped least recently used first once
+ * the total size passes BandCacheSize. A size of 0 (the default) turns
+ * it off.
+ *
+ * The key is everything which decides what the band renders to: the
+ * digest of the band's commands, the band's position and size, the
+ * layout of the buffer, and the settings of the target device that
+ * playback depends on. The device is described by its name and
+ * parameters rather than its address, since a freed device can be
+ * reallocated at the same address with other settings, and so that
+ * rendering threads (which have their own devices) share entries.
+ * The caller must clear the key (memset) before filling it in, because
+ * keys are compared with memcmp.
+ */
+typedef struct gx_band_cache_key_s {
+    byte digest[16];		/* MD5 of the commands played back for the band */
+    char dname[32];		/* name of the target device, truncated */
+    int page_width, page_height;
+    float resolution[2];
+    int num_components, polarity, gray_index;
+    uint max_gray, max_color, dither_grays, dither_colors;
+    int text_bits, graphics_bits;	/* anti-aliasing */
+    int64_t icc_hash[NUM_DEVICE_PROFILES];	/* device profiles, 0 if none */
+    int64_t proof_hash, link_hash;
+    int icc_rendercond[NUM_DEVICE_PROFILES];	/* intent etc. packed */
+    int icc_flags;		/* devicegraytok, usefastcolor, ... */
+    float black_threshold[2];	/* for blacktext and blackvector */
+    int y, width, height;
+    int depth, num_planes;
+    uint raster;		/* of each plane */
+    int action;			/* the clist playback action */
+} gx_band_cache_key_t;
+
+typedef struct gx_band_cache_s gx_band_cache_t;
+
+/* Set the maximum total size of the cached bands, evicting as needed. */
+int gx_band_cache_set_size(gs_memory_t *mem, int64_t size);
+
+int64_t gx_band_cache_size(const gs_memory_t *mem);
+
+/* True if the cache is on, so that the caller needs to compute a key. */
+bool gx_band_cache_enabled(const gs_memory_t *mem);
+
+/*
+ * Look the key up, and if found copy the band into mdev, which must be set
+ * up for exactly the band the key describes. Returns 1 if it was found, or
+ * 0 if not.
+ */
+int gx_band_cache_get(const gs_memory_t *mem, const gx_band_cache_key_t *key,
+                      gx_device_memory *mdev);
+
+/* Save the band rendered in mdev. Failure to allocate just means the band
+ * isn't cached. */
+void gx_band_cache_put(const gs_memory_t *mem, const gx_band_cache_key_t *key,
+                       const gx_device_memory *mdev);
+
+/* Free the cache, when the library instance is finished. */
+void gx_band_cache_free(gs_memory_t *mem);
+
+#endif /* gxbandcache_INCLUDED */
@@ -29,6 +29,9 @@
 #ifdef WITH_CAL
 #include "cal.h"
 #endif
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 typedef int art_s32;
 
@@ -3214,6 +3217,320 @@ compose_group_nonknockout_nonblend_isolated_nomask_common(byte *tos_ptr, bool to
         backdrop_ptr, /*has_matte*/0, n_chan, /*additive*/1, /*num_spots*/0, /*overprint*/0, /*drawn_comps*/0, x0, y0, x1, y1, pblend_procs, pdev, 1);
 }
 
+#ifdef HAVE_SSE2
+/* SSE2 version of the Normal blend of an isolated group with no shape, tags,
+ * spots or alpha_g, as done by the nomask and allmask functions above. 8
+ * pixels are done at a time in 16 bit lanes, giving the same results as the
+ * C code. The src_scale division is done in single precision floats, which
+ * is exact for these operand ranges. Only the first (width & ~7) columns are
+ * done here, the caller does the rest with the C code.
+ *
+ * If mask_row_ptr is NULL, every pixel uses 'alpha' and pixels whose source
+ * alpha becomes 0 are left alone (as the nomask code does). Otherwise the
+ * pixel alpha is 'alpha' times the mask after mask_tr_fn, and only pixels with
+ * zero source alpha before the mask is applied are skipped (as the allmask
+ * code does).
+ */
+static void
+compose_group_isolated_normal_sse2(byte *gs_restrict tos_ptr, intptr_t tos_planestride, intptr_t tos_rowstride,
+                                   byte *gs_restrict nos_ptr, intptr_t nos_planestride, intptr_t nos_rowstride,
+                                   byte *gs_restrict mask_row_ptr, intptr_t mask_rowstride, const byte *gs_restrict mask_tr_fn,
+                                   byte alpha, int n_chan, int width, int height)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ff = _mm_set1_epi16(0xff);
+    const __m128i round = _mm_set1_epi16(0x80);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i half = _mm_set1_epi16((short)0x8000);
+    const __m128i half32 = _mm_set1_epi32(0x8000);
+    int width8 = width & ~7;
+    int x, y, i;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width8; x += 8) {
+            byte *tos = tos_ptr + x;
+            byte *nos = nos_ptr + x;
+            __m128i s0, a_s, a_b, a_r, t, pa;
+            __m128i active, copy, scale, lo32, hi32, keep8;
+            __m128 num, den;
+
+            s0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(tos + n_chan * tos_planestride)), zero);
+            active = _mm_xor_si128(_mm_cmpeq_epi16(s0, zero), _mm_set1_epi16(-1));
+            if (_mm_movemask_epi8(active) == 0)
+                continue;
+            if (mask_row_ptr != NULL) {
+                byte m[8];
+
+                for (i = 0; i < 8; i++) {
+                    int tmp = alpha * mask_tr_fn[mask_row_ptr[x + i]] + 0x80;
+                    m[i] = (tmp + (tmp >> 8)) >> 8;
+                }
+                pa = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)m), zero);
+            } else
+                pa = _mm_set1_epi16(alpha);
+
+            /* a_s = src_alpha * pix_alpha (exact when pix_alpha == 255) */
+            t = _mm_add_epi16(_mm_mullo_epi16(s0, pa), round);
+            a_s = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            if (mask_row_ptr == NULL)
+                active = _mm_andnot_si128(_mm_cmpeq_epi16(a_s, zero), active);
+
+            /* Result alpha is Union of backdrop and source alpha */
+            a_b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(nos + n_chan * nos_planestride)), zero);
+            t = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(ff, a_b), _mm_sub_epi16(ff, a_s)), round);
+            a_r = _mm_sub_epi16(ff, _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8));
+
+            /* When a_s == a_r (including a_b == 0) the source color is copied */
+            copy = _mm_cmpeq_epi16(a_s, a_r);
+
+            /* src_scale = ((a_s << 16) + (a_r >> 1)) / a_r, as 16 bits when !copy */
+            t = _mm_max_epi16(a_r, one);
+            num = _mm_cvtepi32_ps(_mm_add_epi32(_mm_slli_epi32(_mm_unpacklo_epi16(a_s, zero), 16),
+                                                _mm_srli_epi32(_mm_unpacklo_epi16(t, zero), 1)));
+            den = _mm_cvtepi32_ps(_mm_unpacklo_epi16(t, zero));
+            lo32 = _mm_sub_epi32(_mm_cvttps_epi32(_mm_div_ps(num, den)), half32);
+            num = _mm_cvtepi32_ps(_mm_add_epi32(_mm_slli_epi32(_mm_unpackhi_epi16(a_s, zero), 16),
+                                                _mm_srli_epi32(_mm_unpackhi_epi16(t, zero), 1)));
+            den = _mm_cvtepi32_ps(_mm_unpackhi_epi16(t, zero));
+            hi32 = _mm_sub_epi32(_mm_cvttps_epi32(_mm_div_ps(num, den)), half32);
+            scale = _mm_xor_si128(_mm_packs_epi32(lo32, hi32), half);
+
+            keep8 = _mm_packs_epi16(_mm_xor_si128(active, _mm_set1_epi16(-1)), zero);
+
+            /* c_b + ((src_scale * (c_s - c_b) + 0x8000) >> 16), with the   */
+            /* product of the 16 bit scale and |c_s - c_b| split in halves */
+            for (i = 0; i < n_chan; i++) {
+                __m128i nb = _mm_loadl_epi64((const __m128i *)(nos + i * nos_planestride));
+                __m128i c_s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(tos + i * tos_planestride)), zero);
+                __m128i c_b = _mm_unpacklo_epi8(nb, zero);
+                __m128i d = _mm_sub_epi16(c_s, c_b);
+                __m128i neg = _mm_cmplt_epi16(d, zero);
+                __m128i ad = _mm_sub_epi16(_mm_xor_si128(d, neg), neg);
+                __m128i ph = _mm_mulhi_epu16(scale, ad);
+                __m128i pl = _mm_mullo_epi16(scale, ad);
+                __m128i up = _mm_add_epi16(ph, _mm_srli_epi16(pl, 15));
+                __m128i down = _mm_add_epi16(ph, _mm_min_epi16(_mm_subs_epu16(pl, half), one));
+                __m128i delta = _mm_or_si128(_mm_and_si128(neg, down), _mm_andnot_si128(neg, up));
+                __m128i r;
+
+                delta = _mm_sub_epi16(_mm_xor_si128(delta, neg), neg);
+                r = _mm_add_epi16(c_b, delta);
+                r = _mm_or_si128(_mm_and_si128(copy, c_s), _mm_andnot_si128(copy, r));
+                r = _mm_packus_epi16(r, zero);
+                r = _mm_or_si128(_mm_and_si128(keep8, nb), _mm_andnot_si128(keep8, r));
+                _mm_storel_epi64((__m128i *)(nos + i * nos_planestride), r);
+            }
+            t = _mm_packus_epi16(a_r, zero);
+            t = _mm_or_si128(_mm_and_si128(keep8, _mm_packus_epi16(a_b, zero)), _mm_andnot_si128(keep8, t));
+            _mm_storel_epi64((__m128i *)(nos + n_chan * nos_planestride), t);
+        }
+        tos_ptr += tos_rowstride;
+        nos_ptr += nos_rowstride;
+        if (mask_row_ptr != NULL)
+            mask_row_ptr += mask_rowstride;
+    }
+}
+
+/* With gcc and clang we can also build an AVX2 version, doing 16 pixels
+   at a time, and pick it at run time if the CPU has it (as gxht_thresh.c
+   does). */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define COMPOSE_AVX2
+
+#include <immintrin.h>
+
+/* Same as compose_group_isolated_normal_sse2, for the first (width & ~15)
+   columns. Pixels that are left alone get their old values blended back
+   in 16 bits, before packing, rather than in 8. */
+__attribute__((target("avx2"))) static void
+compose_group_isolated_normal_avx2(byte *gs_restrict tos_ptr, intptr_t tos_planestride, intptr_t tos_rowstride,
+                                   byte *gs_restrict nos_ptr, intptr_t nos_planestride, intptr_t nos_rowstride,
+                                   byte *gs_restrict mask_row_ptr, intptr_t mask_rowstride, const byte *gs_restrict mask_tr_fn,
+                                   byte alpha, int n_chan, int width, int height)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(-1);
+    const __m256i ff = _mm256_set1_epi16(0xff);
+    const __m256i round = _mm256_set1_epi16(0x80);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i half = _mm256_set1_epi16((short)0x8000);
+    const __m256i half32 = _mm256_set1_epi32(0x8000);
+    int width16 = width & ~15;
+    int x, y, i;
+
+/* Load 16 bytes as 16 bit lanes, and pack 16 bit lanes back to 16 bytes */
+#define LOAD16(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define STORE16(p, v) _mm_storeu_si128((__m128i *)(p),\
+    _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(v, zero), 0xd8)))
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width16; x += 16) {
+            byte *tos = tos_ptr + x;
+            byte *nos = nos_ptr + x;
+            __m256i s0, a_s, a_b, a_r, t, pa;
+            __m256i active, copy, scale, lo32, hi32;
+            __m256 num, den;
+
+            s0 = LOAD16(tos + n_chan * tos_planestride);
+            active = _mm256_xor_si256(_mm256_cmpeq_epi16(s0, zero), ones);
+            if (_mm256_movemask_epi8(active) == 0)
+                continue;
+            if (mask_row_ptr != NULL) {
+                byte m[16];
+
+                for (i = 0; i < 16; i++) {
+                    int tmp = alpha * mask_tr_fn[mask_row_ptr[x + i]] + 0x80;
+                    m[i] = (tmp + (tmp >> 8)) >> 8;
+                }
+                pa = LOAD16(m);
+            } else
+                pa = _mm256_set1_epi16(alpha);
+
+            /* a_s = src_alpha * pix_alpha (exact when pix_alpha == 255) */
+            t = _mm256_add_epi16(_mm256_mullo_epi16(s0, pa), round);
+            a_s = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+            if (mask_row_ptr == NULL)
+                active = _mm256_andnot_si256(_mm256_cmpeq_epi16(a_s, zero), active);
+
+            /* Result alpha is Union of backdrop and source alpha */
+            a_b = LOAD16(nos + n_chan * nos_planestride);
+            t = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(ff, a_b), _mm256_sub_epi16(ff, a_s)), round);
+            a_r = _mm256_sub_epi16(ff, _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8));
+
+            /* When a_s == a_r (including a_b == 0) the source color is copied */
+            copy = _mm256_cmpeq_epi16(a_s, a_r);
+
+            /* src_scale = ((a_s << 16) + (a_r >> 1)) / a_r, as 16 bits when !copy */
+            t = _mm256_max_epi16(a_r, one);
+            num = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(a_s)), 16),
+                                                      _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(t)), 1)));
+            den = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(t)));
+            lo32 = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_div_ps(num, den)), half32);
+            num = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(a_s, 1)), 16),
+                                                      _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(t, 1)), 1)));
+            den = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(t, 1)));
+            hi32 = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_div_ps(num, den)), half32);
+            scale = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo32, hi32), 0xd8);
+            scale = _mm256_xor_si256(scale, half);
+
+            /* c_b + ((src_scale * (c_s - c_b) + 0x8000) >> 16), with the   */
+            /* product of the 16 bit scale and |c_s - c_b| split in halves */
+            for (i = 0; i < n_chan; i++) {
+                __m256i c_s = LOAD16(tos + i * tos_planestride);
+                __m256i c_b = LOAD16(nos + i * nos_planestride);
+                __m256i d = _mm256_sub_epi16(c_s, c_b);
+                __m256i neg = _mm256_cmpgt_epi16(zero, d);
+                __m256i ad = _mm256_sub_epi16(_mm256_xor_si256(d, neg), neg);
+                __m256i ph = _mm256_mulhi_epu16(scale, ad);
+                __m256i pl = _mm256_mullo_epi16(scale, ad);
+                __m256i up = _mm256_add_epi16(ph, _mm256_srli_epi16(pl, 15));
+                __m256i down = _mm256_add_epi16(ph, _mm256_min_epi16(_mm256_subs_epu16(pl, half), one));
+                __m256i delta = _mm256_blendv_epi8(up, down, neg);
+                __m256i r;
+
+                delta = _mm256_sub_epi16(_mm256_xor_si256(delta, neg), neg);
+                r = _mm256_add_epi16(c_b, delta);
+                r = _mm256_blendv_epi8(r, c_s, copy);
+                r = _mm256_blendv_epi8(c_b, r, active);
+                STORE16(nos + i * nos_planestride, r);
+            }
+            t = _mm256_blendv_epi8(a_b, a_r, active);
+            STORE16(nos + n_chan * nos_planestride, t);
+        }
+        tos_ptr += tos_rowstride;
+        nos_ptr += nos_rowstride;
+        if (mask_row_ptr != NULL)
+            mask_row_ptr += mask_rowstride;
+    }
+#undef LOAD16
+#undef STORE16
+}
+
+static int
+compose_use_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+/* Run the widest of the kernels above that the CPU has on the first
+   (width & ~7) columns, leaving the rest to the C code. */
+static void
+compose_group_isolated_normal_simd(byte *tos_ptr, intptr_t tos_planestride, intptr_t tos_rowstride,
+                                   byte *nos_ptr, intptr_t nos_planestride, intptr_t nos_rowstride,
+                                   byte *mask_row_ptr, intptr_t mask_rowstride, const byte *mask_tr_fn,
+                                   byte alpha, int n_chan, int width, int height)
+{
+#ifdef COMPOSE_AVX2
+    if (compose_use_avx2()) {
+        int done = width & ~15;
+
+        compose_group_isolated_normal_avx2(tos_ptr, tos_planestride, tos_rowstride,
+                                           nos_ptr, nos_planestride, nos_rowstride,
+                                           mask_row_ptr, mask_rowstride, mask_tr_fn,
+                                           alpha, n_chan, width, height);
+        tos_ptr += done;
+        nos_ptr += done;
+        if (mask_row_ptr != NULL)
+            mask_row_ptr += done;
+        width -= done;
+    }
+#endif
+    compose_group_isolated_normal_sse2(tos_ptr, tos_planestride, tos_rowstride,
+                                       nos_ptr, nos_planestride, nos_rowstride,
+                                       mask_row_ptr, mask_rowstride, mask_tr_fn,
+                                       alpha, n_chan, width, height);
+}
+
+static void
+compose_group_nonknockout_nonblend_isolated_allmask_simd(byte *tos_ptr, bool tos_isolated, intptr_t tos_planestride, intptr_t tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
+              intptr_t tos_shape_offset, intptr_t tos_alpha_g_offset, intptr_t tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
+              byte *nos_ptr, bool nos_isolated, intptr_t nos_planestride, intptr_t nos_rowstride, byte *nos_alpha_g_ptr, bool nos_knockout,
+              intptr_t nos_shape_offset, intptr_t nos_tag_offset,
+              byte *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, byte mask_bg_alpha, const byte *mask_tr_fn,
+              byte *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int done = (x1 - x0) & ~7;
+
+    compose_group_isolated_normal_simd(tos_ptr, tos_planestride, tos_rowstride,
+                                       nos_ptr, nos_planestride, nos_rowstride,
+                                       mask_row_ptr, maskbuf->rowstride, mask_tr_fn,
+                                       alpha, n_chan, x1 - x0, y1 - y0);
+    if (x0 + done < x1)
+        compose_group_nonknockout_nonblend_isolated_allmask_common(tos_ptr + done, tos_isolated, tos_planestride, tos_rowstride, alpha, shape, blend_mode, tos_has_shape,
+            tos_shape_offset, tos_alpha_g_offset, tos_tag_offset, tos_has_tag, tos_alpha_g_ptr,
+            nos_ptr + done, nos_isolated, nos_planestride, nos_rowstride, nos_alpha_g_ptr, nos_knockout,
+            nos_shape_offset, nos_tag_offset, mask_row_ptr + done, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn,
+            backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + done, y0, x1, y1, pblend_procs, pdev);
+}
+
+static void
+compose_group_nonknockout_nonblend_isolated_nomask_simd(byte *tos_ptr, bool tos_isolated, intptr_t tos_planestride, intptr_t tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
+              intptr_t tos_shape_offset, intptr_t tos_alpha_g_offset, intptr_t tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
+              byte *nos_ptr, bool nos_isolated, intptr_t nos_planestride, intptr_t nos_rowstride, byte *nos_alpha_g_ptr, bool nos_knockout,
+              intptr_t nos_shape_offset, intptr_t nos_tag_offset,
+              byte *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, byte mask_bg_alpha, const byte *mask_tr_fn,
+              byte *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int done = (x1 - x0) & ~7;
+
+    compose_group_isolated_normal_simd(tos_ptr, tos_planestride, tos_rowstride,
+                                       nos_ptr, nos_planestride, nos_rowstride,
+                                       NULL, 0, NULL, alpha, n_chan, x1 - x0, y1 - y0);
+    if (x0 + done < x1)
+        compose_group_nonknockout_nonblend_isolated_nomask_common(tos_ptr + done, tos_isolated, tos_planestride, tos_rowstride, alpha, shape, blend_mode, tos_has_shape,
+            tos_shape_offset, tos_alpha_g_offset, tos_tag_offset, tos_has_tag, tos_alpha_g_ptr,
+            nos_ptr + done, nos_isolated, nos_planestride, nos_rowstride, nos_alpha_g_ptr, nos_knockout,
+            nos_shape_offset, nos_tag_offset, mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn,
+            backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + done, y0, x1, y1, pblend_procs, pdev);
+}
+#endif
+
 static void
 compose_group_nonknockout_nonblend_nonisolated_mask_common(byte *tos_ptr, bool tos_isolated, intptr_t tos_planestride, intptr_t tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
               intptr_t tos_shape_offset, intptr_t tos_alpha_g_offset, intptr_t tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
@@ -3346,6 +3663,7 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_tiles(nos, x0, y0, x1, y1);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -3459,7 +3777,11 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
                     /* AVX and SSE accelerations only valid if maskbuf transfer
                        function is identity and we have no matte color replacement */
                     if (is_ident && !has_matte) {
+#ifdef HAVE_SSE2
+                        fn = compose_group_nonknockout_nonblend_isolated_allmask_simd;
+#else
                         fn = compose_group_nonknockout_nonblend_isolated_allmask_common;
+#endif
 #ifdef WITH_CAL
 			fn = (art_pdf_compose_group_fn)cal_get_compose_group(
 					 memory->gs_lib_ctx->core->cal_ctx,
@@ -3467,7 +3789,11 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
 					 tos->n_chan-1);
 #endif
                     } else {
+#ifdef HAVE_SSE2
+                        fn = compose_group_nonknockout_nonblend_isolated_allmask_simd;
+#else
                         fn = compose_group_nonknockout_nonblend_isolated_allmask_common;
+#endif
                     }
                 } else
                     fn = &compose_group_nonknockout_nonblend_isolated_mask_common;
@@ -3476,7 +3802,11 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
                     /* Outside mask */
                     fn = &compose_group_nonknockout_nonblend_isolated_mask_common;
                 } else
+#ifdef HAVE_SSE2
+                    fn = &compose_group_nonknockout_nonblend_isolated_nomask_simd;
+#else
                     fn = &compose_group_nonknockout_nonblend_isolated_nomask_common;
+#endif
         } else {
             if (has_mask || maskbuf) /* 4% */
                 fn = &compose_group_nonknockout_nonblend_nonisolated_mask_common;
@@ -4120,6 +4450,7 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_tiles(nos, x0, y0, x1, y1);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -4271,6 +4602,44 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
 #endif
 }
 
+void
+pdf14_buf_mark_tiles(pdf14_buf *buf, int x0, int y0, int x1, int y1)
+{
+    int tx0, tx1, ty0, ty1, tx, ty;
+    byte *row;
+
+    if (buf->tile_dirty == NULL || x0 >= x1 || y0 >= y1)
+        return;
+    tx0 = (x0 >> PDF14_TILE_SHIFT) - buf->tile_x0;
+    tx1 = ((x1 - 1) >> PDF14_TILE_SHIFT) - buf->tile_x0 + 1;
+    ty0 = (y0 >> PDF14_TILE_SHIFT) - buf->tile_y0;
+    ty1 = ((y1 - 1) >> PDF14_TILE_SHIFT) - buf->tile_y0 + 1;
+    if (tx0 < 0)
+        tx0 = 0;
+    if (ty0 < 0)
+        ty0 = 0;
+    if (tx1 > buf->tile_cols)
+        tx1 = buf->tile_cols;
+    if (ty1 > buf->tile_rows)
+        ty1 = buf->tile_rows;
+    if (tx0 >= tx1)
+        return;
+    row = buf->tile_dirty + ty0 * buf->tile_raster;
+    for (ty = ty0; ty < ty1; ty++, row += buf->tile_raster)
+        for (tx = tx0; tx < tx1; tx++)
+            row[tx >> 3] |= 0x80 >> (tx & 7);
+}
+
+void
+pdf14_buf_mark_dirty(pdf14_buf *buf, int x0, int y0, int x1, int y1)
+{
+    if (x0 < buf->dirty.p.x) buf->dirty.p.x = x0;
+    if (y0 < buf->dirty.p.y) buf->dirty.p.y = y0;
+    if (x1 > buf->dirty.q.x) buf->dirty.q.x = x1;
+    if (y1 > buf->dirty.q.y) buf->dirty.q.y = y1;
+    pdf14_buf_mark_tiles(buf, x0, y0, x1, y1);
+}
+
 void
 pdf14_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
               int x0, int x1, int y0, int y1, int n_chan, bool additive,
@@ -4334,6 +4703,7 @@ do_compose_alphaless_group(pdf14_buf *tos, pdf14_buf *nos,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_tiles(nos, x0, y0, x1, y1);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -4471,6 +4841,7 @@ do_compose_alphaless_group16(pdf14_buf *tos, pdf14_buf *nos,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_tiles(nos, x0, y0, x1, y1);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -5114,10 +5485,7 @@ do_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
     dst_ptr = buf->data + (x - buf->rect.p.x) + (y - buf->rect.p.y) * rowstride;
     src_alpha = 255-src_alpha;
     shape = 255-shape;
@@ -5755,10 +6123,7 @@ do_mark_fill_rectangle16(gx_device * dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, x + w, y + h);
     dst_ptr = (uint16_t *)(buf->data + (x - buf->rect.p.x) * 2 + (y - buf->rect.p.y) * rowstride);
     src_alpha = 65535-src_alpha;
     shape = 65535-shape;
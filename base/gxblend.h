@@ -349,6 +349,13 @@ int pdf14_preserve_backdrop_cm(pdf14_buf *buf, cmm_profile_t *group_profile,
                                gs_memory_t *memory, gs_gstate *pgs,
                                gx_device *dev, bool knockout_buff);
 
+/* Record a mark covering x0 <= x < x1, y0 <= y < y1 in the dirty bbox
+   and tile map of buf. */
+void pdf14_buf_mark_dirty(pdf14_buf *buf, int x0, int y0, int x1, int y1);
+
+/* As above, but only updates the tile map. */
+void pdf14_buf_mark_tiles(pdf14_buf *buf, int x0, int y0, int x1, int y1);
+
 void pdf14_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
               int x0, int x1, int y0, int y1, int n_chan, bool additive,
               const pdf14_nonseparable_blending_procs_t * pblend_procs,
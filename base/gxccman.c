@@ -35,6 +35,7 @@
 #include "gxttfb.h"
 #include "gxfont42.h"
 #include "gxobj.h"
+#include "gsmemrep.h"
 
 /* Define the descriptors for the cache structures. */
 private_st_cached_fm_pair();
@@ -538,6 +539,7 @@ gx_alloc_char_bits(gs_font_dir * dir, gx_device_memory * pdev,
     *pcc = cc;
     if (cc == 0)
         return 0;
+    gs_memreport_cache(dir->memory, gs_memreport_font_cache, dir->ccache.bsize);
     if_debug4m('k', pdev->memory, "[k]adding char "PRI_INTPTR":%u(%u,%u)\n",
                (intptr_t)cc, (uint)icdsize, iwidth, iheight);
 
@@ -592,6 +594,7 @@ gx_free_cached_char(gs_font_dir * dir, cached_char * cc)
     if_debug2m('k', dir->memory, "[k]freeing char "PRI_INTPTR", pair="PRI_INTPTR"\n",
                (intptr_t)cc, (intptr_t)cc_pair(cc));
     gx_bits_cache_free((gx_bits_cache *) & dir->ccache, &cc->head, cck);
+    gs_memreport_cache(dir->memory, gs_memreport_font_cache, dir->ccache.bsize);
 }
 
 /* Add a character to the cache */
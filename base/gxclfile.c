@@ -229,8 +229,40 @@ typedef struct
     int64_t pos;
     int64_t filesize;		/* filesize maintained by clist_fwrite */
     CL_CACHE *cache;
+    byte *map;			/* whole file mapped for reading, or NULL */
+    int64_t map_size;
+    bool map_failed;		/* don't try to map again until next write */
 } IFILE;
 
+/* Files too big for the CL_CACHE slots are mapped into memory for reading
+ * (where the platform can) so that each read is a copy, with no system call,
+ * and readers on different threads don't share anything but the page cache.
+ * A mapping covers the file as it was when reading started; writing drops it.
+ */
+#define CL_MAP_MIN_SIZE ((int64_t)CL_CACHE_NSLOTS << CL_CACHE_SLOT_SIZE_LOG2)
+
+static void
+clist_map_file(IFILE *ifile)
+{
+    if (ifile->map != NULL || ifile->map_failed || ifile->filesize < CL_MAP_MIN_SIZE)
+        return;
+    ifile->map = gp_fmap(ifile->f, ifile->filesize);
+    if (ifile->map == NULL)
+        ifile->map_failed = true;
+    else
+        ifile->map_size = ifile->filesize;
+}
+
+static void
+clist_unmap_file(IFILE *ifile)
+{
+    if (ifile->map != NULL)
+        gp_funmap(ifile->map, ifile->map_size);
+    ifile->map = NULL;
+    ifile->map_size = 0;
+    ifile->map_failed = false;
+}
+
 static void
 file_to_fake_path(clist_file_ptr file, char fname[gp_file_name_sizeof])
 {
@@ -262,6 +294,9 @@ static IFILE *wrap_file(gs_memory_t *mem, gp_file *f, const char *fmode)
     ifile->pos = 0;
     ifile->filesize = 0;
     ifile->cache = cl_cache_alloc(ifile->mem);
+    ifile->map = NULL;
+    ifile->map_size = 0;
+    ifile->map_failed = false;
     return ifile;
 }
 
@@ -269,6 +304,7 @@ static int clist_close_file(IFILE *ifile)
 {
     int res = 0;
     if (ifile) {
+        clist_unmap_file(ifile);
         if (ifile->f != NULL)
             res = gp_fclose(ifile->f);
         if (ifile->cache != NULL)
@@ -368,6 +404,7 @@ clist_fwrite_chars(const void *data, uint len, clist_file_ptr cf)
     if (res >= 0)
         icf->pos += len;
     icf->filesize = icf->pos;	/* write truncates file */
+    clist_unmap_file(icf);
     if (!CL_CACHE_NEEDS_INIT(icf->cache)) {
         /* writing invalidates the read cache */
         cl_cache_destroy(icf->cache);
@@ -387,6 +424,15 @@ clist_fread_chars(void *data, uint len, clist_file_ptr cf)
         IFILE *icf = (IFILE *)cf;
         byte *dp = data;
 
+        clist_map_file(icf);
+        if (icf->map != NULL) {
+            if (icf->pos < icf->map_size) {
+                nread = min(len, icf->map_size - icf->pos);
+                memcpy(data, icf->map + icf->pos, nread);
+                icf->pos += nread;
+            }
+            return nread;
+        }
         /* if we have a cache, check if it needs init, and do it */
         if (CL_CACHE_NEEDS_INIT(icf->cache)) {
             icf->cache = cl_cache_read_init(icf->cache, CL_CACHE_NSLOTS, 1<<CL_CACHE_SLOT_SIZE_LOG2, icf->filesize);
@@ -484,6 +530,8 @@ clist_rewind(clist_file_ptr cf, bool discard_data, const char *fname)
              * new scratch file. */
             char tfname[gp_file_name_sizeof] = {0};
             const gs_memory_t *mem = ocf->f->memory;
+            clist_unmap_file(ocf);
+            clist_unmap_file((IFILE *)cf);
             gp_fclose(ocf->f);
             ocf->f = gp_open_scratch_file_rm(mem, gp_scratch_file_name_prefix, tfname, fmode);
             if (ocf->f == NULL)
@@ -552,6 +600,19 @@ clist_fseek(clist_file_ptr cf, int64_t offset, int mode, const char *ignore_fnam
     return res;
 }
 
+static void
+clist_readahead(clist_file_ptr cf, int64_t offset, int64_t len)
+{
+    IFILE *ifile = (IFILE *)cf;
+
+    if (!gp_can_share_fdesc() || offset >= ifile->filesize)
+        return;
+    if (len > ifile->filesize - offset)
+        len = ifile->filesize - offset;
+    clist_map_file(ifile);
+    gp_fwillneed(ifile->f, ifile->map, offset, len);
+}
+
 static clist_io_procs_t clist_io_procs_file = {
     clist_fopen,
     clist_fclose,
@@ -563,6 +624,7 @@ static clist_io_procs_t clist_io_procs_file = {
     clist_ftell,
     clist_rewind,
     clist_fseek,
+    clist_readahead,
 };
 
 init_proc(gs_gxclfile_init);
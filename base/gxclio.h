@@ -88,6 +88,13 @@ struct clist_io_procs_s {
     int (*rewind)(clist_file_ptr cf, bool discard_data, const char *fname);
 
     int (*fseek)(clist_file_ptr cf, int64_t offset, int mode, const char *fname);
+
+    /*
+     * Hint that len bytes from offset will be read soon, so that the
+     * implementation can start fetching them in the background. NULL if the
+     * implementation has no use for this.
+     */
+    void (*readahead)(clist_file_ptr cf, int64_t offset, int64_t len);
 };
 
 typedef struct clist_io_procs_s clist_io_procs_t;
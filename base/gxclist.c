@@ -32,6 +32,7 @@
 #include "gsicc_cache.h"
 #include "gxdevsop.h"
 #include "gxobj.h"
+#include "gsmemrep.h"
 
 #include "valgrind.h"
 
@@ -867,6 +868,12 @@ clist_end_page(gx_device_clist_writer * cldev)
     if (cldev->page_info.cfile != 0)
         cldev->page_info.io_procs->set_memory_warning(cldev->page_info.cfile, 0);
 
+    if (cldev->pinst == NULL)
+        gs_memreport_clist_page(cldev->memory, cldev->nbands,
+                                cldev->page_info.band_params.BandHeight,
+                                cldev->page_info.band_params.BandBufferSpace,
+                                cldev->page_info.tile_cache_size);
+
 #ifdef DEBUG
     if (gs_debug_c('l') | gs_debug_c(':')) {
         if (cb.pos <= 0xFFFFFFFF)
@@ -383,6 +383,7 @@ struct gx_device_clist_writer_s {
 #define clist_disable_copy_alpha (1 << 6) /* target does not support copy_alpha */
 
 typedef struct clist_render_thread_control_s clist_render_thread_control_t;
+typedef struct clist_render_sched_s clist_render_sched_t;
 
 /* Define the state of a band list when reading. */
 /* For normal rasterizing, pages and num_pages are both 0. */
@@ -400,6 +401,7 @@ typedef struct gx_device_clist_reader_s {
     int curr_render_thread;		/* index into array */
     int thread_lookahead_direction;	/* +1 or -1 */
     int next_band;			/* may be < 0 or >= num bands when no more remain to render */
+    clist_render_sched_t *render_sched;	/* NULL unless using the band scheduler */
     struct gx_device_clist_reader_s *orig_clist_device;
                                         /* This is NULL, unless we're in a worker thread for clist
                                          * rendering, in which case it's a pointer back to the
@@ -20,6 +20,8 @@
 #include "gserrors.h"
 #include "gxclmem.h"
 #include "gssprintf.h"
+#include "gslibctx.h"
+#include "stdint_.h"
 
 #include "valgrind.h"
 
@@ -68,6 +70,12 @@ COMPRESSION.
    used during subsequent compression when the last logical block of the
    file fills the physical block.
 
+   The compressor is normally the stream RLE or zlib filter given by the
+   compress_method template. With the BandListCompression user parameter
+   set to "fast", the built in codec below is used instead (see "Fast
+   codec"), which stores blocks that do not compress well as they are, so
+   reading them back costs a copy rather than a decode.
+
 DECOMPRESSION.
 
    During reading the clist, if the logical block points to an uncompressed
@@ -169,6 +177,8 @@ static int memfile_init_empty(MEMFILE * f);
 static int memfile_set_memory_warning(clist_file_ptr cf, int bytes_left);
 static int memfile_fclose(clist_file_ptr cf, const char *fname, bool delete);
 static int memfile_get_pdata(MEMFILE * f);
+static int compress_log_blk_fast(MEMFILE * f, LOG_MEMFILE_BLK * bp);
+static int decompress_log_blk_fast(MEMFILE * f, LOG_MEMFILE_BLK * bp, byte *data);
 
 /************************************************/
 /*   #define DEBUG      /- force statistics -/  */
@@ -233,6 +243,181 @@ allocateWithReserve(
     return block;
 }
 
+/* ----------------------------- Fast codec --------------------------- */
+
+/*
+ * When BandListCompression is "fast" the blocks are compressed with the
+ * simple LZ77 coder below instead of the stream templates. It is in the
+ * style of LZ4: a sequence is a token byte holding a 4 bit literal count
+ * and a 4 bit match length, then the literals, then a 2 byte offset back
+ * into the block. Counts of 15 continue in following bytes, 255 at a time.
+ * The last sequence has literals only. It doesn't compress as well as zlib
+ * but it is several times faster in both directions.
+ *
+ * Each block is stored as a 2 byte length followed by that many bytes of
+ * compressed data, or a length of 0 followed by the raw block when the
+ * block doesn't compress by at least FAST_MIN_SAVING (image data that was
+ * already compressed, for instance), so that we don't spend time decoding
+ * a block that didn't save any memory.
+ */
+#define FAST_HASH_BITS 12
+#define FAST_MIN_MATCH 4
+#define FAST_MAX_OFFSET 65535
+#define FAST_MIN_SAVING (MEMFILE_DATA_SIZE / 8)
+#define FAST_BUF_SIZE (MEMFILE_DATA_SIZE + MEMFILE_DATA_SIZE / 255 + 16)
+
+static inline uint32_t
+fast_read32(const byte *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint
+fast_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - FAST_HASH_BITS);
+}
+
+/* Write a count which didn't fit in its 4 bits of the token. */
+static inline byte *
+fast_put_count(byte *op, uint n)
+{
+    for (; n >= 255; n -= 255)
+        *op++ = 255;
+    *op++ = (byte)n;
+    return op;
+}
+
+/* Returns the compressed size, or -1 if that would be more than max_size. */
+static int
+fast_compress(const byte *src, uint len, byte *dst, uint max_size)
+{
+    uint16_t table[1 << FAST_HASH_BITS];
+    const byte *ip = src, *anchor = src;
+    const byte *const end = src + len;
+    const byte *const match_limit = end - FAST_MIN_MATCH;
+    byte *op = dst;
+    byte *const oend = dst + max_size;
+    uint misses = 0;
+
+    memset(table, 0, sizeof(table));
+    while (ip <= match_limit) {
+        uint32_t seq = fast_read32(ip);
+        uint h = fast_hash(seq);
+        const byte *ref = src + table[h];
+        const byte *mp, *rp;
+        uint lits, mlen;
+
+        table[h] = (uint16_t)(ip - src);
+        if (ref >= ip || ip - ref > FAST_MAX_OFFSET || fast_read32(ref) != seq) {
+            /* Step faster through data which isn't matching. */
+            ip += 1 + (misses++ >> 5);
+            continue;
+        }
+        misses = 0;
+        mp = ip + FAST_MIN_MATCH;
+        rp = ref + FAST_MIN_MATCH;
+        while (mp < end && *mp == *rp)
+            mp++, rp++;
+        lits = ip - anchor;
+        mlen = (mp - ip) - FAST_MIN_MATCH;
+        /* token, literal count, literals, offset, match length */
+        if (oend - op < (int)(1 + lits / 255 + 1 + lits + 2 + mlen / 255 + 1))
+            return -1;
+        *op = (byte)((min(lits, 15) << 4) | min(mlen, 15));
+        op++;
+        if (lits >= 15)
+            op = fast_put_count(op, lits - 15);
+        memcpy(op, anchor, lits);
+        op += lits;
+        op[0] = (byte)(ip - ref);
+        op[1] = (byte)((ip - ref) >> 8);
+        op += 2;
+        if (mlen >= 15)
+            op = fast_put_count(op, mlen - 15);
+        ip = anchor = mp;
+    }
+    /* The last literals */
+    {
+        uint lits = end - anchor;
+
+        if (oend - op < (int)(1 + lits / 255 + 1 + lits))
+            return -1;
+        *op++ = (byte)(min(lits, 15) << 4);
+        if (lits >= 15)
+            op = fast_put_count(op, lits - 15);
+        memcpy(op, anchor, lits);
+        op += lits;
+    }
+    return op - dst;
+}
+
+/* Returns 0, or -1 if the data is bad or doesn't decode to exactly len bytes. */
+static int
+fast_decompress(const byte *src, uint size, byte *dst, uint len)
+{
+    const byte *ip = src;
+    const byte *const iend = src + size;
+    byte *op = dst;
+    byte *const oend = dst + len;
+
+    while (ip < iend) {
+        uint token = *ip++;
+        uint n = token >> 4;
+        uint offset;
+        byte b;
+
+        if (n == 15) {
+            do {
+                if (ip == iend)
+                    return -1;
+                b = *ip++;
+                n += b;
+            } while (b == 255);
+        }
+        if (n > (uint)(iend - ip) || n > (uint)(oend - op))
+            return -1;
+        memcpy(op, ip, n);
+        op += n;
+        ip += n;
+        if (ip == iend)
+            break;              /* the last sequence has no match */
+        if (iend - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint)(op - dst))
+            return -1;
+        n = token & 15;
+        if (n == 15) {
+            do {
+                if (ip == iend)
+                    return -1;
+                b = *ip++;
+                n += b;
+            } while (b == 255);
+        }
+        n += FAST_MIN_MATCH;
+        if (n > (uint)(oend - op))
+            return -1;
+        if (offset >= n)
+            memcpy(op, op - offset, n);
+        else {
+            /* Overlapping copy repeats the last 'offset' bytes */
+            const byte *mp = op - offset;
+            uint i;
+
+            for (i = 0; i < n; i++)
+                op[i] = mp[i];
+        }
+        op += n;
+    }
+    return op == oend ? 0 : -1;
+}
+
 /* ---------------- Open/close/unlink ---------------- */
 
 static int
@@ -279,6 +464,7 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             f->data_memory = data_mem;
             f->compress_state = 0;              /* Not used by reader instance */
             f->decompress_state = 0;    /* make clean for GC, or alloc'n failure */
+            f->fast_buf = NULL;
             f->reservePhysBlockChain = NULL;
             f->reservePhysBlockCount = 0;
             f->reserveLogBlockChain = NULL;
@@ -354,6 +540,8 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
     f->openlist = NULL;
     f->base_memfile = NULL;
     f->total_space = 0;
+    f->fast_compress = mem->gs_lib_ctx->band_list_fast_compression;
+    f->fast_buf = NULL;
     f->reservePhysBlockChain = NULL;
     f->reservePhysBlockCount = 0;
     f->reserveLogBlockChain = NULL;
@@ -464,13 +652,15 @@ memfile_fclose(clist_file_ptr cf, const char *fname, bool delete)
                 f->log_head = NULL;
 
                 /* Free any internal compressor state. */
-                if (f->compressor_initialized) {
+                if (f->compressor_initialized && !f->fast_compress) {
                     if (f->decompress_state->templat->release != 0)
                         (*f->decompress_state->templat->release) (f->decompress_state);
                     if (f->compress_state->templat->release != 0)
                         (*f->compress_state->templat->release) (f->compress_state);
-                    f->compressor_initialized = false;
                 }
+                f->compressor_initialized = false;
+                gs_free_object(f->data_memory, f->fast_buf, "memfile_fclose(fast_buf)");
+                f->fast_buf = NULL;
                 /* free the raw buffers                                           */
                 while (f->raw_head != NULL) {
                     RAW_BUFFER *tmpraw = f->raw_head->fwd;
@@ -615,6 +805,9 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
     byte *start_ptr;
     PHYS_MEMFILE_BLK *newphys;
 
+    if (f->fast_compress)
+        return compress_log_blk_fast(f, bp);
+
     /* compress this block */
     f->rd.ptr = (const byte *)(bp->phys_blk->data) - 1;
     f->rd.limit = f->rd.ptr + MEMFILE_DATA_SIZE;
@@ -674,6 +867,154 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
     return (status < 0 ? gs_note_error(gs_error_ioerror) : ecode);
 }                               /* end "compress_log_blk()"                                     */
 
+/* Start a new physical block for the compressed data when the current one is full. */
+static int      /* ret 0 ok, -ve error, or +ve low-memory warning */
+memfile_next_phys(MEMFILE * f)
+{
+    PHYS_MEMFILE_BLK *newphys;
+    int code;
+
+    newphys =
+        allocateWithReserve(f, sizeof(*newphys), &code, "memfile newphys",
+                            "memfile_next_phys : MALLOC for 'newphys' failed\n");
+    if (code < 0)
+        return code;
+    newphys->link = NULL;
+    newphys->data_limit = (char *)newphys->data - 1;    /* empty */
+    f->phys_curr->link = newphys;
+    f->phys_curr = newphys;
+    f->wt.ptr = (byte *) (newphys->data) - 1;
+    f->wt.limit = f->wt.ptr + MEMFILE_DATA_SIZE;
+    return code;
+}
+
+/* Append compressed data at f->wt, running on into new physical blocks as needed. */
+static int      /* ret 0 ok, -ve error, or +ve low-memory warning */
+memfile_put_compressed(MEMFILE * f, const byte *data, uint count)
+{
+    int ecode = 0;
+    int code;
+
+    while (count > 0) {
+        uint n = f->wt.limit - f->wt.ptr;
+
+        if (n == 0) {
+            if ((code = memfile_next_phys(f)) < 0)
+                return code;
+            ecode |= code;
+            continue;
+        }
+        if (n > count)
+            n = count;
+        memcpy(f->wt.ptr + 1, data, n);
+        f->wt.ptr += n;
+        f->phys_curr->data_limit = (char *)(f->wt.ptr);
+        data += n;
+        count -= n;
+    }
+    return ecode;
+}
+
+static int      /* ret 0 ok, -ve error, or +ve low-memory warning */
+compress_log_blk_fast(MEMFILE * f, LOG_MEMFILE_BLK * bp)
+{
+    const byte *src = (const byte *)bp->phys_blk->data;
+    int ecode = 0;
+    int code, size;
+
+    size = fast_compress(src, MEMFILE_DATA_SIZE, f->fast_buf + 2,
+                         MEMFILE_DATA_SIZE - FAST_MIN_SAVING);
+    if (size < 0) {
+        /* Not worth it, store the block as it is */
+        f->fast_buf[0] = f->fast_buf[1] = 0;
+    } else {
+        f->fast_buf[0] = (byte)size;
+        f->fast_buf[1] = (byte)(size >> 8);
+    }
+    if (f->wt.ptr == f->wt.limit) {
+        if ((code = memfile_next_phys(f)) < 0)
+            return code;
+        ecode |= code;
+    }
+    bp->phys_blk = f->phys_curr;
+    bp->phys_pdata = (char *)(f->wt.ptr) + 1;
+    if (size < 0) {
+        if ((code = memfile_put_compressed(f, f->fast_buf, 2)) < 0)
+            return code;
+        ecode |= code;
+        code = memfile_put_compressed(f, src, MEMFILE_DATA_SIZE);
+    } else
+        code = memfile_put_compressed(f, f->fast_buf, size + 2);
+    if (code < 0)
+        return code;
+    ecode |= code;
+#ifdef DEBUG
+    tot_compressed += (size < 0 ? MEMFILE_DATA_SIZE : size) + 2;
+#endif
+    return ecode;
+}
+
+/* Read 'count' bytes of compressed data, which may run on into the next
+ * physical block. */
+static int
+memfile_get_compressed(PHYS_MEMFILE_BLK **pphys, const byte **pp, byte *data, uint count)
+{
+    while (count > 0) {
+        const byte *limit = (const byte *)(*pphys)->data_limit;
+        uint n;
+
+        if (*pp > limit) {
+            *pphys = (*pphys)->link;
+            if (*pphys == NULL)
+                return_error(gs_error_ioerror);
+            *pp = (const byte *)(*pphys)->data;
+            continue;
+        }
+        n = limit - *pp + 1;
+        if (n > count)
+            n = count;
+        memcpy(data, *pp, n);
+        *pp += n;
+        data += n;
+        count -= n;
+    }
+    return 0;
+}
+
+/* Decompress the data for 'bp' into the raw buffer 'data'. */
+static int
+decompress_log_blk_fast(MEMFILE * f, LOG_MEMFILE_BLK * bp, byte *data)
+{
+    PHYS_MEMFILE_BLK *phys = bp->phys_blk;
+    const byte *p = (const byte *)bp->phys_pdata;
+    byte hdr[2];
+    uint size;
+    int code;
+
+    if ((code = memfile_get_compressed(&phys, &p, hdr, 2)) < 0)
+        return code;
+    size = hdr[0] | (hdr[1] << 8);
+    if (size == 0)              /* stored */
+        return memfile_get_compressed(&phys, &p, data, MEMFILE_DATA_SIZE);
+    if (p + size - 1 > (const byte *)phys->data_limit) {
+        /* Runs on into the next physical block, so gather it up first */
+        if (f->fast_buf == NULL) {
+            f->fast_buf = gs_alloc_bytes(f->data_memory, FAST_BUF_SIZE,
+                                         "decompress_log_blk_fast");
+            if (f->fast_buf == NULL)
+                return_error(gs_error_VMerror);
+        }
+        if ((code = memfile_get_compressed(&phys, &p, f->fast_buf, size)) < 0)
+            return code;
+        p = f->fast_buf;
+    }
+    if (fast_decompress(p, size, data, MEMFILE_DATA_SIZE) < 0) {
+        emprintf(f->memory, "Band list decompression failed!\n");
+        return_error(gs_error_ioerror);
+    }
+    return 0;
+}
+
 /*      Internal (private) routine to handle end of logical block       */
 static int      /* ret 0 ok, -ve error, or +ve low-memory warning */
 memfile_next_blk(MEMFILE * f)
@@ -715,7 +1056,12 @@ memfile_next_blk(MEMFILE * f)
             if (!f->compressor_initialized) {
                 int code = 0;
 
-                if (f->compress_state->templat->init != 0)
+                if (f->fast_compress) {
+                    f->fast_buf = gs_alloc_bytes(f->data_memory, FAST_BUF_SIZE,
+                                                 "memfile_next_blk(fast_buf)");
+                    if (f->fast_buf == NULL)
+                        code = gs_error_VMerror;
+                } else if (f->compress_state->templat->init != 0)
                     code = (*f->compress_state->templat->init) (f->compress_state);
                 if (code < 0)
                     return_error(gs_error_VMerror);  /****** BOGUS ******/
@@ -894,7 +1240,7 @@ memfile_get_pdata(MEMFILE * f)
             num_raw_buffers = i + 1;    /* if MALLOC failed, then OK    */
             if_debug1m(':', f->memory, "[:]Number of raw buffers allocated=%d\n",
                        num_raw_buffers);
-            if (f->decompress_state->templat->init != 0)
+            if (!f->fast_compress && f->decompress_state->templat->init != 0)
                 code = (*f->decompress_state->templat->init)
                     (f->decompress_state);
             if (code < 0)
@@ -924,46 +1270,54 @@ memfile_get_pdata(MEMFILE * f)
             f->raw_head->log_blk = bp;
 
             /* Decompress the data into this raw block                     */
-            /* Initialize the decompressor                              */
-            if (f->decompress_state->templat->reinit != 0)
-                (*f->decompress_state->templat->reinit) (f->decompress_state);
-            /* Set pointers and call the decompress routine             */
-            f->wt.ptr = (byte *) (f->raw_head->data) - 1;
-            f->wt.limit = f->wt.ptr + MEMFILE_DATA_SIZE;
-            f->rd.ptr = (const byte *)(bp->phys_pdata) - 1;
-            f->rd.limit = (const byte *)bp->phys_blk->data_limit;
-#ifdef DEBUG
-            decomp_wt_ptr0 = f->wt.ptr;
-            decomp_wt_limit0 = f->wt.limit;
-            decomp_rd_ptr0 = f->rd.ptr;
-            decomp_rd_limit0 = f->rd.limit;
-#endif
-            status = (*f->decompress_state->templat->process)
-                (f->decompress_state, &(f->rd), &(f->wt), true);
-            if (status == 0) {  /* More input data needed */
-                /* switch to next block and continue decompress             */
-                int back_up = 0;        /* adjust pointer backwards     */
-
-                if (f->rd.ptr != f->rd.limit) {
-                    /* transfer remainder bytes from the previous block      */
-                    back_up = f->rd.limit - f->rd.ptr;
-                    for (i = 0; i < back_up; i++)
-                        *(bp->phys_blk->link->data - back_up + i) = *++f->rd.ptr;
+            if (f->fast_compress) {
+                code = decompress_log_blk_fast(f, bp, (byte *)f->raw_head->data);
+                if (code < 0) {
+                    f->raw_head->log_blk = NULL;
+                    return code;
                 }
-                f->rd.ptr = (const byte *)bp->phys_blk->link->data - back_up - 1;
-                f->rd.limit = (const byte *)bp->phys_blk->link->data_limit;
+            } else {
+                /* Initialize the decompressor                              */
+                if (f->decompress_state->templat->reinit != 0)
+                    (*f->decompress_state->templat->reinit) (f->decompress_state);
+                /* Set pointers and call the decompress routine             */
+                f->wt.ptr = (byte *) (f->raw_head->data) - 1;
+                f->wt.limit = f->wt.ptr + MEMFILE_DATA_SIZE;
+                f->rd.ptr = (const byte *)(bp->phys_pdata) - 1;
+                f->rd.limit = (const byte *)bp->phys_blk->data_limit;
 #ifdef DEBUG
-                decomp_wt_ptr1 = f->wt.ptr;
-                decomp_wt_limit1 = f->wt.limit;
-                decomp_rd_ptr1 = f->rd.ptr;
-                decomp_rd_limit1 = f->rd.limit;
+                decomp_wt_ptr0 = f->wt.ptr;
+                decomp_wt_limit0 = f->wt.limit;
+                decomp_rd_ptr0 = f->rd.ptr;
+                decomp_rd_limit0 = f->rd.limit;
 #endif
                 status = (*f->decompress_state->templat->process)
                     (f->decompress_state, &(f->rd), &(f->wt), true);
-                if (status == 0) {
-                    emprintf(f->memory,
-                             "Decompression required more than one full block!\n");
-                    return_error(gs_error_Fatal);
+                if (status == 0) {  /* More input data needed */
+                    /* switch to next block and continue decompress             */
+                    int back_up = 0;        /* adjust pointer backwards     */
+
+                    if (f->rd.ptr != f->rd.limit) {
+                        /* transfer remainder bytes from the previous block      */
+                        back_up = f->rd.limit - f->rd.ptr;
+                        for (i = 0; i < back_up; i++)
+                            *(bp->phys_blk->link->data - back_up + i) = *++f->rd.ptr;
+                    }
+                    f->rd.ptr = (const byte *)bp->phys_blk->link->data - back_up - 1;
+                    f->rd.limit = (const byte *)bp->phys_blk->link->data_limit;
+#ifdef DEBUG
+                    decomp_wt_ptr1 = f->wt.ptr;
+                    decomp_wt_limit1 = f->wt.limit;
+                    decomp_rd_ptr1 = f->rd.ptr;
+                    decomp_rd_limit1 = f->rd.limit;
+#endif
+                    status = (*f->decompress_state->templat->process)
+                        (f->decompress_state, &(f->rd), &(f->wt), true);
+                    if (status == 0) {
+                        emprintf(f->memory,
+                                 "Decompression required more than one full block!\n");
+                        return_error(gs_error_Fatal);
+                    }
                 }
             }
             bp->raw_block = f->raw_head;        /* point to raw block           */
@@ -1185,13 +1539,15 @@ memfile_free_mem(MEMFILE * f)
     f->log_head = NULL;
 
     /* Free any internal compressor state. */
-    if (f->compressor_initialized) {
+    if (f->compressor_initialized && !f->fast_compress) {
         if (f->decompress_state->templat->release != 0)
             (*f->decompress_state->templat->release) (f->decompress_state);
         if (f->compress_state->templat->release != 0)
             (*f->compress_state->templat->release) (f->compress_state);
-        f->compressor_initialized = false;
     }
+    f->compressor_initialized = false;
+    gs_free_object(f->data_memory, f->fast_buf, "memfile_free_mem(fast_buf)");
+    f->fast_buf = NULL;
     /* free the raw buffers                                           */
     while (f->raw_head != NULL) {
         RAW_BUFFER *tmpraw = f->raw_head->fwd;
@@ -1260,6 +1616,7 @@ clist_io_procs_t clist_io_procs_memory = {
     memfile_ftell,
     memfile_rewind,
     memfile_fseek,
+    NULL,			/* readahead: the data is already in memory */
 };
 
 init_proc(gs_gxclmem_init);
@@ -118,6 +118,8 @@ struct MEMFILE_s {
     stream_cursor_read rd;	/* use .ptr, .limit */			/******* READER INSTANCE *******/
     stream_cursor_write wt;	/* use .ptr, .limit */			/******* READER INSTANCE *******/
     bool compressor_initialized;
+    bool fast_compress;		/* use the built in fast codec, not the templates */
+    byte *fast_buf;		/* scratch for the fast codec */	/******* READER INSTANCE *******/
     stream_state *compress_state;
     stream_state *decompress_state;					/******* READER INSTANCE *******/
 };
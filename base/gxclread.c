@@ -31,6 +31,9 @@
 #include "gdevp14.h"
 #include "gsmemory.h"
 #include "gsicc_cache.h"
+#include "gstrace.h"
+#include "gsmd5.h"
+#include "gxbandcache.h"
 /*
  * We really don't like the fact that gdevprn.h is included here, since
  * command lists are supposed to be usable for purposes other than printer
@@ -81,17 +84,68 @@ typedef struct stream_band_read_state_s {
 #endif
 } stream_band_read_state;
 
+/*
+ * Ranges of the cfile that are needed for the band(s) and closer together than
+ * this are asked for with a single readahead. The bfile must have at least
+ * BAND_READAHEAD_MIN_BLOCKS entries before it's worth scanning it twice.
+ */
+#define BAND_READAHEAD_GAP 65536
+#define BAND_READAHEAD_MIN_BLOCKS 256
+
+/*
+ * Walk the bfile (the index of where each band's commands are in the cfile)
+ * and ask the I/O implementation to start fetching all the cfile data we are
+ * going to read for these bands, so that it arrives while we're rendering.
+ * The bfile is left rewound.
+ */
+static int
+s_band_read_ahead(stream_band_read_state *ss)
+{
+    const clist_io_procs_t *io_procs = ss->page_info.io_procs;
+    clist_file_ptr bfile = ss->page_info.bfile;
+    cmd_block prev, next;
+    int64_t start = -1, end = 0;
+
+    prev.band_min = prev.band_max = 0;
+    prev.pos = 0;
+    while (io_procs->ftell(bfile) < ss->page_info.bfile_end_pos) {
+        if (io_procs->fread_chars(&next, sizeof(next), bfile) < sizeof(next))
+            break;
+        /* As in s_band_read_process, the data for a block runs from the
+         * previous block's position to this one's. */
+        if (!(ss->band_last < prev.band_min || ss->band_first > prev.band_max) &&
+            next.pos > prev.pos) {
+            if (start >= 0 && prev.pos - end > BAND_READAHEAD_GAP) {
+                io_procs->readahead(ss->page_info.cfile, start, end - start);
+                start = -1;
+            }
+            if (start < 0)
+                start = prev.pos;
+            end = next.pos;
+        }
+        prev = next;
+    }
+    if (start >= 0)
+        io_procs->readahead(ss->page_info.cfile, start, end - start);
+    return io_procs->rewind(bfile, false, ss->page_info.bfname);
+}
+
 static int
 s_band_read_init(stream_state * st)
 {
     stream_band_read_state *const ss = (stream_band_read_state *) st;
     const clist_io_procs_t *io_procs = ss->page_info.io_procs;
+    int code;
 
     ss->left = 0;
     ss->b_this.band_min = 0;
     ss->b_this.band_max = 0;
     ss->b_this.pos = 0;
-    return io_procs->rewind(ss->page_info.bfile, false, ss->page_info.bfname);
+    code = io_procs->rewind(ss->page_info.bfile, false, ss->page_info.bfname);
+    if (code >= 0 && io_procs->readahead != NULL &&
+        ss->page_info.bfile_end_pos >= BAND_READAHEAD_MIN_BLOCKS * sizeof(cmd_block))
+        code = s_band_read_ahead(ss);
+    return code;
 }
 
 #ifdef DEBUG
@@ -710,6 +764,7 @@ clist_render_init(gx_device_clist *dev)
     crdev->icc_table = NULL;
     crdev->color_usage_array = NULL;
     crdev->render_threads = NULL;
+    crdev->render_sched = NULL;
 
     return 0;
 }
@@ -907,6 +962,127 @@ clist_rasterize_lines(gx_device *dev, int y, int line_count,
     return line_count;
 }
 
+/*
+ * Compute the MD5 digest of the commands which playback of bands
+ * band_first..band_last reads from the cfile, for the band cache. This is
+ * the same walk through the bfile as s_band_read_process makes.
+ */
+static int
+clist_band_digest(gx_band_page_info_t *pinfo, int band_first, int band_last,
+                  byte digest[16])
+{
+    const clist_io_procs_t *io_procs = pinfo->io_procs;
+    cmd_block prev, next;
+    gs_md5_state_t md5;
+    byte buf[cbuf_size];
+    int code;
+
+    code = io_procs->rewind(pinfo->bfile, false, pinfo->bfname);
+    if (code < 0)
+        return code;
+    gs_md5_init(&md5);
+    prev.band_min = prev.band_max = 0;
+    prev.pos = 0;
+    while (io_procs->ftell(pinfo->bfile) < pinfo->bfile_end_pos) {
+        if (io_procs->fread_chars(&next, sizeof(next), pinfo->bfile) < sizeof(next))
+            return_error(gs_error_ioerror);
+        if (!(band_last < prev.band_min || band_first > prev.band_max) &&
+            next.pos > prev.pos) {
+            int64_t pos = prev.pos;
+
+            io_procs->fseek(pinfo->cfile, pos, SEEK_SET, pinfo->cfname);
+            while (pos < next.pos) {
+                uint count = (uint)min(next.pos - pos, sizeof(buf));
+
+                if (io_procs->fread_chars(buf, count, pinfo->cfile) != count)
+                    return_error(gs_error_ioerror);
+                gs_md5_append(&md5, buf, count);
+                pos += count;
+            }
+        }
+        prev = next;
+    }
+    gs_md5_finish(&md5, digest);
+    return 0;
+}
+
+/* Hash of an ICC profile for the band cache key, or an error if it is
+   not known and cannot be computed. */
+static int
+clist_band_cache_profile_hash(cmm_profile_t *profile, int64_t *hash)
+{
+    if (profile == NULL)
+        *hash = 0;
+    else if (profile->hash_is_valid)
+        *hash = profile->hashcode;
+    else if (profile->buffer != NULL)
+        *hash = gsicc_get_hash(profile);
+    else
+        return_error(gs_error_undefined);
+    return 0;
+}
+
+/*
+ * Fill in the part of a band cache key which describes the device: its
+ * name, page size, resolution, color model and ICC settings.
+ */
+static int
+clist_band_cache_key_device(gx_device_clist_reader *crdev,
+                            gx_band_cache_key_t *key)
+{
+    const gx_device_color_info *cinfo = &crdev->color_info;
+    cmm_dev_profile_t *icc_struct = crdev->icc_struct;
+    int code, i;
+
+    strncpy(key->dname, crdev->dname, sizeof(key->dname) - 1);
+    key->page_width = crdev->width;
+    key->page_height = crdev->height;
+    key->resolution[0] = crdev->HWResolution[0];
+    key->resolution[1] = crdev->HWResolution[1];
+    key->num_components = cinfo->num_components;
+    key->polarity = cinfo->polarity;
+    key->gray_index = cinfo->gray_index;
+    key->max_gray = cinfo->max_gray;
+    key->max_color = cinfo->max_color;
+    key->dither_grays = cinfo->dither_grays;
+    key->dither_colors = cinfo->dither_colors;
+    key->text_bits = cinfo->anti_alias.text_bits;
+    key->graphics_bits = cinfo->anti_alias.graphics_bits;
+    if (icc_struct == NULL)
+        return 0;
+    for (i = 0; i < NUM_DEVICE_PROFILES; i++) {
+        const gsicc_rendering_param_t *rc = &icc_struct->rendercond[i];
+
+        code = clist_band_cache_profile_hash(icc_struct->device_profile[i],
+                                             &key->icc_hash[i]);
+        if (code < 0)
+            return code;
+        key->icc_rendercond[i] = (rc->rendering_intent & 0xff) |
+                                 ((rc->black_point_comp & 0xff) << 8) |
+                                 ((rc->preserve_black & 0xff) << 16) |
+                                 ((rc->override_icc ? 1 : 0) << 24) |
+                                 ((rc->cmm & 0x7f) << 25);
+    }
+    code = clist_band_cache_profile_hash(icc_struct->proof_profile,
+                                         &key->proof_hash);
+    if (code < 0)
+        return code;
+    code = clist_band_cache_profile_hash(icc_struct->link_profile,
+                                         &key->link_hash);
+    if (code < 0)
+        return code;
+    key->icc_flags = (icc_struct->devicegraytok ? 1 : 0) |
+                     (icc_struct->usefastcolor ? 2 : 0) |
+                     (icc_struct->blacktext ? 4 : 0) |
+                     (icc_struct->blackvector ? 8 : 0) |
+                     (icc_struct->supports_devn ? 16 : 0) |
+                     (icc_struct->prebandthreshold ? 32 : 0) |
+                     ((int)icc_struct->overprint_control << 8);
+    key->black_threshold[0] = icc_struct->blackthresholdL;
+    key->black_threshold[1] = icc_struct->blackthresholdC;
+    return 0;
+}
+
 /*
  * Render a rectangle to a client-supplied device.  There is no necessary
  * relationship between band boundaries and the region being rendered.
@@ -927,6 +1103,8 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
     int code = 0;
     int i;
     bool save_pageneutralcolor;
+    gx_band_cache_key_t key;
+    bool use_cache;
 
     if (render_plane)
         crdev->yplane = *render_plane;
@@ -996,12 +1174,51 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
             pdf14_needed |= (crdev->color_usage_array[band].trans_bbox.p.y <=
             crdev->color_usage_array[band].trans_bbox.q.y) ? true : false;
 
+        /*
+         * A whole band of the current page, rendered into a memory device,
+         * may already be in the band cache from an earlier page. Bands with
+         * transparency also depend on page level data outside the band's
+         * commands, so we leave those alone. So does gray detection: the
+         * neutral color monitor would not see the colors of a band taken
+         * from the cache.
+         */
+        use_cache = ppages == NULL && clear && !pdf14_needed &&
+            !save_pageneutralcolor && !crdev->icc_struct->graydetection &&
+            band_first == band_last && crdev->yplane.index < 0 &&
+            prect->p.x == 0 && prect->q.x == bdev->width &&
+            prect->p.y == band_first * band_height &&
+            prect->q.y == min(prect->p.y + band_height, crdev->height) &&
+            gs_device_is_memory(bdev) &&
+            ((gx_device_memory *)bdev)->height == prect->q.y - prect->p.y &&
+            gx_band_cache_enabled(crdev->memory);
+        if (use_cache) {
+            gx_device_memory *mdev = (gx_device_memory *)bdev;
+
+            memset(&key, 0x00, sizeof(key));
+            if (clist_band_cache_key_device(crdev, &key) < 0)
+                use_cache = false;
+            key.y = prect->p.y;
+            key.width = mdev->width;
+            key.height = mdev->height;
+            key.depth = mdev->color_info.depth;
+            key.num_planes = mdev->num_planar_planes ? mdev->num_planar_planes : 1;
+            key.raster = mdev->raster;
+            key.action = playback_action_render_no_pdf14;
+            if (!use_cache ||
+                clist_band_digest(pinfo, band_first, band_last, key.digest) < 0)
+                use_cache = false;	/* just render it */
+            else if (gx_band_cache_get(crdev->memory, &key, mdev))
+                continue;
+        }
+
         code = clist_playback_file_bands(pdf14_needed ?
                                          playback_action_render : playback_action_render_no_pdf14,
                                          crdev, pinfo,
                                          bdev, band_first, band_last,
                                          prect->p.x - bdev->band_offset_x,
                                          prect->p.y);
+        if (code >= 0 && use_cache)
+            gx_band_cache_put(crdev->memory, &key, (gx_device_memory *)bdev);
     }
     crdev->icc_struct->pageneutralcolor = save_pageneutralcolor;	/* restore it */
     return code;
@@ -1047,6 +1264,7 @@ clist_playback_file_bands(clist_playback_action action,
     if (rs.page_info.cfile != 0 && rs.page_info.bfile != 0) {
         stream s;
         byte sbuf[cbuf_size];
+        int64_t start;
         static const stream_procs no_procs = {
             s_std_noavailable, s_std_noseek, s_std_read_reset,
             s_std_read_flush, s_std_close, s_band_read_process
@@ -1062,7 +1280,9 @@ clist_playback_file_bands(clist_playback_action action,
         s.foreign = 1;
         s.state = (stream_state *)&rs;
 
+        start = gs_trace_begin(mem);
         code = clist_playback_band(action, crdev, &s, target, x0, y0, mem);
+        gs_trace_end(mem, start, "clist", "playback", band_first);
 #	ifdef DEBUG
         s_band_read_dnit_offset_map(crdev, (stream_state *)&rs);
 #	endif
@@ -37,11 +37,21 @@
 #include "gsicc_manage.h"
 #include "gstrans.h"
 #include "gzht.h"		/* for gx_ht_cache_default_bits_size */
+#include "gsmemrep.h"
 
 /* Forward reference prototypes */
 static int clist_start_render_thread(gx_device *dev, int thread_index, int band);
 static void clist_render_thread(void* param);
 static void clist_render_thread_no_output_fn(void* param);
+static void clist_render_worker(void *param);
+
+/* When bands are output in order, allocate this many band 'slots' for
+ * each worker thread, so that idle workers can render ahead of the band
+ * the output is waiting for. Each slot costs a device copy and a band
+ * buffer, so keep this small. */
+#ifndef CLIST_RENDER_SLOTS_PER_THREAD
+#  define CLIST_RENDER_SLOTS_PER_THREAD 2
+#endif
 
 /*
         Notes on operation:
@@ -88,6 +98,16 @@ static void clist_render_thread_no_output_fn(void* param);
         idle waiting for all the other bands to finish before it can
         output, and resume its next rendering.
 
+        To reduce this, when there are more bands than threads, the
+        traditional mechanism uses the 'band scheduler': we set up
+        CLIST_RENDER_SLOTS_PER_THREAD band slots (each with its own
+        device copy and band buffer) for each worker thread. All free
+        slots are queued with the next bands in output order, and a
+        worker that becomes idle takes the band the output is waiting
+        for if that is queued, otherwise the queued band that the writer
+        recorded as most expensive. So one slow band no longer stops the
+        other workers, as long as there are slots for them to render into.
+
         For devices that are not dependent on the order in which data
         becomes available, we therefore offer a second mechanism; by
         setting output_fn to NULL, we indicate that process_fn will
@@ -299,8 +319,11 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
     /* The threads are maintained until clist_finish_page.  At which
        point, the threads are torn down, the master clist reader device
        is changed to writer, and the icc_table and the icc_cache_cl freed */
-    if (dev->icc_struct == ndev->icc_struct) {
-    /* safe to share the link cache */
+    if (dev->icc_struct == ndev->icc_struct ||
+        (!bg_print && gscms_is_threadsafe())) {
+    /* safe to share the link cache. Even if the device profiles had to be
+       cloned above, the clones hash the same, and links from a thread safe
+       CMS do not refer back to the profiles they were built from. */
         ncdev->icc_cache_cl = cdev->icc_cache_cl;
         rc_increment(cdev->icc_cache_cl);		/* FIXME: needs to be incdemented safely */
     } else {
@@ -361,6 +384,142 @@ out_cleanup:
     return NULL;
 }
 
+/*
+ * Estimate the relative cost of rendering each band from what the writer
+ * recorded: the number of command bytes each band reads from the cfile
+ * (found from the block file), plus the area of the band that uses
+ * transparency, since that has to go through the pdf14 compositor.
+ * Only the ordering of the results matters. 'cost' must have room for
+ * nbands + 1 entries. 'crdev' must be a reader device with its own
+ * bfile (i.e. a thread's device) since we move the file position.
+ */
+static void
+clist_estimate_band_costs(gx_device_clist_reader *crdev, int64_t *cost)
+{
+    const clist_io_procs_t *io_procs = crdev->page_info.io_procs;
+    clist_file_ptr bfile = crdev->page_info.bfile;
+    int nbands = crdev->nbands;
+    cmd_block prev, cb;
+    int64_t sum = 0;
+    int band;
+
+    memset(cost, 0, (nbands + 1) * sizeof(*cost));
+    if (bfile != NULL && io_procs->rewind(bfile, false, crdev->page_info.bfname) >= 0) {
+        prev.band_min = prev.band_max = 0;
+        prev.pos = 0;
+        while (io_procs->ftell(bfile) < crdev->page_info.bfile_end_pos &&
+               io_procs->fread_chars(&cb, sizeof(cb), bfile) == sizeof(cb)) {
+            /* As in s_band_read_process, the data from prev.pos up to cb.pos
+             * is read by the bands in prev's range. Ranges that cover many
+             * bands are accumulated as differences to keep this linear. */
+            if (prev.band_min >= 0 && prev.band_min < nbands &&
+                prev.band_max >= prev.band_min && cb.pos > prev.pos) {
+                cost[prev.band_min] += cb.pos - prev.pos;
+                cost[min(prev.band_max, nbands - 1) + 1] -= cb.pos - prev.pos;
+            }
+            prev = cb;
+        }
+        (void)io_procs->rewind(bfile, false, crdev->page_info.bfname);
+    }
+    for (band = 0; band < nbands; band++) {
+        sum += cost[band];
+        cost[band] = sum;
+        if (crdev->color_usage_array != NULL) {
+            const gs_int_rect *tb = &crdev->color_usage_array[band].trans_bbox;
+
+            if (tb->p.y <= tb->q.y && tb->p.x <= tb->q.x)
+                cost[band] += (int64_t)(tb->q.x - tb->p.x + 1) * (tb->q.y - tb->p.y + 1) *
+                              crdev->color_info.num_components;
+        }
+    }
+}
+
+/* Stop the band scheduler's workers and free it. Any queued bands must
+ * have been rendered before this is called. */
+static void
+clist_free_render_sched(gx_device_clist_reader *crdev)
+{
+    clist_render_sched_t *sched = crdev->render_sched;
+    int i;
+
+    if (sched == NULL)
+        return;
+    if (sched->num_workers > 0) {
+        gx_monitor_enter(sched->lock);
+        sched->quit = true;
+        for (i = 0; i < sched->num_workers; i++) {
+            if (sched->workers[i].idle) {
+                sched->workers[i].idle = false;
+                gx_semaphore_signal(sched->workers[i].wake);
+            }
+        }
+        gx_monitor_leave(sched->lock);
+        for (i = 0; i < sched->num_workers; i++)
+            gp_thread_finish(sched->workers[i].thread);
+    }
+    if (sched->workers != NULL) {
+        for (i = 0; i < sched->num_workers; i++)
+            gx_semaphore_free(sched->workers[i].wake);
+    }
+    gx_monitor_free(sched->lock);
+    gs_free_object(sched->memory, sched->band_cost, "clist_free_render_sched");
+    gs_free_object(sched->memory, sched->workers, "clist_free_render_sched");
+    gs_free_object(sched->memory, sched, "clist_free_render_sched");
+    crdev->render_sched = NULL;
+}
+
+/* Set up the band scheduler, with num_workers threads serving the
+ * render_threads slots. On failure, nothing is left allocated and the
+ * caller can run each slot on its own thread as before. */
+static int
+clist_setup_render_sched(gx_device_clist_reader *crdev, int num_workers)
+{
+    gs_memory_t *mem = crdev->bandlist_memory->thread_safe_memory;
+    clist_render_sched_t *sched;
+    int i, code = 0;
+
+    sched = (clist_render_sched_t *)gs_alloc_bytes(mem, sizeof(*sched),
+                                                   "clist_setup_render_sched");
+    if (sched == NULL)
+        return_error(gs_error_VMerror);
+    memset(sched, 0, sizeof(*sched));
+    sched->memory = mem;
+    sched->consumer_band = -1;
+    crdev->render_sched = sched;
+    sched->workers = (clist_render_worker_t *)gs_alloc_byte_array(mem, num_workers,
+                                                  sizeof(clist_render_worker_t),
+                                                  "clist_setup_render_sched");
+    sched->band_cost = (int64_t *)gs_alloc_byte_array(mem, crdev->nbands + 1, sizeof(int64_t),
+                                                     "clist_setup_render_sched");
+    if (sched->workers == NULL || sched->band_cost == NULL ||
+        (sched->lock = gx_monitor_label(gx_monitor_alloc(mem), "BandSched")) == NULL) {
+        clist_free_render_sched(crdev);
+        return_error(gs_error_VMerror);
+    }
+    memset(sched->workers, 0, num_workers * sizeof(clist_render_worker_t));
+    clist_estimate_band_costs((gx_device_clist_reader *)crdev->render_threads[0].cdev,
+                              sched->band_cost);
+    for (i = 0; i < num_workers; i++) {
+        clist_render_worker_t *worker = &sched->workers[i];
+
+        worker->crdev = crdev;
+        if ((worker->wake = gx_semaphore_label(gx_semaphore_alloc(mem), "BandWorker")) == NULL)
+            break;
+        code = gp_thread_start(clist_render_worker, worker, &worker->thread);
+        if (code < 0) {
+            gx_semaphore_free(worker->wake);
+            break;
+        }
+        gp_thread_label(worker->thread, "BandWorker");
+        sched->num_workers = i + 1;
+    }
+    if (sched->num_workers == 0) {
+        clist_free_render_sched(crdev);
+        return_error(gs_error_VMerror);
+    }
+    return 0;
+}
+
 /* Set up and start the render threads */
 static int
 clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *options)
@@ -383,8 +542,9 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
     int reserve_size = 2 * 1024 * 1024 + (gx_ht_cache_default_bits_size() * dev->color_info.num_components);
     clist_icctable_entry_t *curr_entry;
     bool deep = device_is_deep(dev);
+    int num_workers;
 
-    crdev->num_render_threads = pdev->num_render_threads_requested;
+    crdev->num_render_threads = num_workers = pdev->num_render_threads_requested;
 
     if(gs_debug[':'] != 0)
         dmprintf1(mem, "%% %d rendering threads requested.\n", pdev->num_render_threads_requested);
@@ -401,11 +561,16 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
             reserve_size += 2 * 1024 * 1024;		/* a worst case estimate */
         }
     }
+    /* don't exceed our limit (allow for BGPrint and main thread) */
+    if (num_workers > MAX_THREADS - 2)
+        num_workers = MAX_THREADS - 2;
+    /* If the output has to be in order, give the workers extra slots to render ahead into */
+    if (options == NULL || options->output_fn != NULL)
+        crdev->num_render_threads = num_workers * CLIST_RENDER_SLOTS_PER_THREAD;
+    else
+        crdev->num_render_threads = num_workers;
     if (crdev->num_render_threads > band_count)
         crdev->num_render_threads = band_count; /* don't bother starting more threads than bands */
-    /* don't exceed our limit (allow for BGPrint and main thread) */
-    if (crdev->num_render_threads > MAX_THREADS - 2)
-        crdev->num_render_threads = MAX_THREADS - 2;
 
     /* Allocate and initialize an array of thread control structures */
     crdev->render_threads = (clist_render_thread_control_t *)
@@ -579,6 +744,10 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
     crdev->num_render_threads = i;
     crdev->curr_render_thread = 0;
     crdev->next_band = band;
+    /* Only use the scheduler if there are more slots than workers. If it
+     * can't be set up, each slot simply gets a thread of its own. */
+    if (i > num_workers)
+        (void)clist_setup_render_sched(crdev, num_workers);
     /* Free up any "reserve" memory we may have allocated, and start the
      * threads since we deferred that in the thread setup loop above.
      * We know if we get here we can start at least 1 thread.
@@ -590,8 +759,13 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
     }
     gs_free_object(mem, reserve_memory_array, "clist_setup_render_threads");
 
-    if(gs_debug[':'] != 0)
-        dmprintf1(mem, "%% Using %d rendering threads\n", i);
+    if(gs_debug[':'] != 0) {
+        if (crdev->render_sched != NULL)
+            dmprintf2(mem, "%% Using %d rendering threads with %d band slots\n",
+                      crdev->render_sched->num_workers, i);
+        else
+            dmprintf1(mem, "%% Using %d rendering threads\n", i);
+    }
 
     return code;
 }
@@ -666,7 +840,7 @@ clist_teardown_render_threads(gx_device *dev)
     gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
     gs_memory_t *mem = cdev->bandlist_memory;
-    int i;
+    int i, num_workers;
 
     if (crdev->render_threads != NULL) {
         /* Wait for all threads to finish */
@@ -676,6 +850,10 @@ clist_teardown_render_threads(gx_device *dev)
             if (thread->status == THREAD_BUSY)
                 gx_semaphore_wait(thread->sema_this);
         }
+        num_workers = crdev->render_sched != NULL ? crdev->render_sched->num_workers :
+                                                    crdev->num_render_threads;
+        /* Nothing is queued now, so the scheduler's workers can stop */
+        clist_free_render_sched(crdev);
         /* then free each thread's memory */
         for (i = (crdev->num_render_threads - 1); i >= 0; i--) {
             clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
@@ -705,6 +883,12 @@ clist_teardown_render_threads(gx_device *dev)
                 dmprintf2(thread->memory, "%% Thread %d total usertime=%ld msec\n", i, thread->cputime);
             dmprintf1(thread->memory, "\nThread %d ", i);
 #endif
+            {
+                gs_memory_status_t status;
+
+                gs_memory_status(thread->memory, &status);
+                gs_memreport_render_thread(mem, num_workers, status.max_used);
+            }
             teardown_device_and_mem_for_thread((gx_device *)thread_cdev, thread->thread, false);
         }
         gs_free_object(mem, crdev->render_threads, "clist_teardown_render_threads");
@@ -737,6 +921,25 @@ clist_start_render_thread(gx_device *dev, int thread_index, int band)
 
     crdev->render_threads[thread_index].band = band;
 
+    if (crdev->render_sched != NULL) {
+        /* Queue the band, and wake a worker if one is idle */
+        clist_render_sched_t *sched = crdev->render_sched;
+        int i;
+
+        crdev->render_threads[thread_index].status = THREAD_BUSY;
+        gx_monitor_enter(sched->lock);
+        crdev->render_threads[thread_index].queued = true;
+        for (i = 0; i < sched->num_workers; i++) {
+            if (sched->workers[i].idle) {
+                sched->workers[i].idle = false;
+                gx_semaphore_signal(sched->workers[i].wake);
+                break;
+            }
+        }
+        gx_monitor_leave(sched->lock);
+        return 0;
+    }
+
     /* Finally, fire it up */
     if (options == NULL || options->output_fn) {
         /* Traditional mechanism, using output_fn. Each thread will
@@ -827,6 +1030,68 @@ clist_render_thread(void *data)
     gx_semaphore_signal(thread->sema_this);
 }
 
+/* Choose the next queued slot for a band scheduler worker to render.
+ * Called with the scheduler lock held. The band the consumer is waiting
+ * for comes first; otherwise take the most expensive queued band, so
+ * that it is started as early as possible, nearest band first on ties. */
+static clist_render_thread_control_t *
+clist_render_sched_pick(gx_device_clist_reader *crdev)
+{
+    clist_render_sched_t *sched = crdev->render_sched;
+    clist_render_thread_control_t *best = NULL;
+    int64_t best_cost = 0;
+    int best_dist = 0;
+    int i;
+
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        clist_render_thread_control_t *thread = &crdev->render_threads[i];
+        int64_t cost;
+        int dist;
+
+        if (!thread->queued)
+            continue;
+        if (thread->band == sched->consumer_band)
+            return thread;
+        cost = sched->band_cost[thread->band];
+        dist = (thread->band - sched->consumer_band) * crdev->thread_lookahead_direction;
+        if (best == NULL || cost > best_cost || (cost == best_cost && dist < best_dist)) {
+            best = thread;
+            best_cost = cost;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+/* A band scheduler worker: render queued slots until told to quit.
+ * Each worker has its own 'wake' semaphore, only signalled after
+ * clearing 'idle', since a gx_semaphore only reliably wakes one waiter. */
+static void
+clist_render_worker(void *data)
+{
+    clist_render_worker_t *worker = (clist_render_worker_t *)data;
+    gx_device_clist_reader *crdev = worker->crdev;
+    clist_render_sched_t *sched = crdev->render_sched;
+    clist_render_thread_control_t *thread;
+
+    gx_monitor_enter(sched->lock);
+    while (!sched->quit) {
+        thread = clist_render_sched_pick(crdev);
+        if (thread != NULL) {
+            thread->queued = false;
+            gx_monitor_leave(sched->lock);
+            clist_render_thread(thread);	/* signals the slot's semaphores */
+            gx_monitor_enter(sched->lock);
+        } else {
+            worker->idle = true;
+            gx_monitor_leave(sched->lock);
+            gx_semaphore_wait(worker->wake);
+            gx_monitor_enter(sched->lock);
+        }
+    }
+    gx_monitor_leave(sched->lock);
+}
+
 /* Used if output_fn == NULL. No blocking required as we no longer need to
  * serialise the calls to output_fn. */
 static void
@@ -932,6 +1197,12 @@ clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_opti
     int band_count = cdev->nbands;
     byte *tmp;                  /* for swapping data areas */
 
+    if (crdev->render_sched != NULL) {
+        /* Let the workers know which band we are about to wait for */
+        gx_monitor_enter(crdev->render_sched->lock);
+        crdev->render_sched->consumer_band = band_needed;
+        gx_monitor_leave(crdev->render_sched->lock);
+    }
     /* We expect that the thread needed will be the 'current' thread */
     if (thread->band != band_needed) {
         int band = band_needed;
@@ -56,6 +56,7 @@ struct clist_render_thread_control_s {
     gx_device *bdev;	/* this thread's buffer device */
     int band;
     gp_thread_id thread;
+    bool queued;	/* waiting for a worker (band scheduler only) */
 
     /* For process_page mode */
     gx_process_page_options_t *options;
@@ -65,4 +66,28 @@ struct clist_render_thread_control_s {
 #endif
 };
 
+/*
+ * Band scheduler, used when bands must be output in order. The
+ * render_threads array then holds more band 'slots' than there are
+ * worker threads, and idle workers take queued bands ahead of the
+ * consumer, most expensive first, rather than each slot owning its
+ * own thread.
+ */
+typedef struct clist_render_worker_s {
+    gx_device_clist_reader *crdev;	/* the device whose slots we render */
+    gx_semaphore_t *wake;	/* signalled when work is queued while we are idle */
+    bool idle;			/* waiting on 'wake' */
+    gp_thread_id thread;
+} clist_render_worker_t;
+
+struct clist_render_sched_s {
+    gs_memory_t *memory;
+    gx_monitor_t *lock;		/* protects everything below, and the slots' 'queued' */
+    int num_workers;
+    clist_render_worker_t *workers;
+    bool quit;
+    int consumer_band;		/* band the consumer is waiting for */
+    int64_t *band_cost;		/* estimated cost per band, from the block file */
+};
+
 #endif /* gxclthrd_INCLUDED */
@@ -27,6 +27,8 @@
 #include "gxcldev.h"
 #include "gxclpath.h"
 #include "gsparams.h"
+#include "gstrace.h"
+#include "gsmemrep.h"
 
 #include "valgrind.h"
 #include <limits.h>
@@ -205,6 +207,7 @@ cmd_write_band(gx_device_clist_writer * cldev, int band_min, int band_max,
     const cmd_prefix *cp = pcl->head;
     int code_b = 0;
     int code_c = 0;
+    int64_t written = 1;
 
     if (cp != 0 || cmd_end != cmd_opv_end_run) {
         clist_file_ptr cfile = cldev->page_info.cfile;
@@ -235,12 +238,16 @@ cmd_write_band(gx_device_clist_writer * cldev, int band_min, int band_max,
                 if_debug2m('L', cldev->memory, "[L] cmd id=%ld at %"PRId64"\n",
                            cp->id, cldev->page_info.io_procs->ftell(cfile));
                 cldev->page_info.io_procs->fwrite_chars(cp + 1, cp->size, cfile);
+                written += cp->size;
             }
             pcl->head = pcl->tail = 0;
         }
         if_debug0m('L', cldev->memory, "[L] adding terminator\n");
         end  = cmd_count_op(cmd_end, 1, cldev->memory);
         cldev->page_info.io_procs->fwrite_chars(&end, 1, cfile);
+        if (cldev->pinst == NULL)   /* not a pattern clist */
+            gs_memreport_clist_band(cldev->memory, band_min, band_max,
+                                    cldev->nbands, written);
         process_interrupts(cldev->memory);
         code_b = cldev->page_info.io_procs->ferror_code(bfile);
         code_c = cldev->page_info.io_procs->ferror_code(cfile);
@@ -305,6 +312,8 @@ cmd_write_buffer(gx_device_clist_writer * cldev, byte cmd_end)
     int nbands = cldev->nbands;
     gx_clist_state *pcls;
     int band;
+    int64_t start = gs_trace_begin(cldev->memory);
+    int64_t size = cldev->cnext - cldev->cbuf;
     int code = cmd_write_band(cldev, cldev->band_range_min,
                               cldev->band_range_max,
                               cldev->band_range_list,
@@ -330,6 +339,7 @@ cmd_write_buffer(gx_device_clist_writer * cldev, byte cmd_end)
     if (gs_debug_c('l'))
         cmd_print_stats(cldev->memory);
 #endif
+    gs_trace_end(cldev->memory, start, "clist", "write_buffer", size);
     return_check_interrupt(cldev->memory, code != 0 ? code : warning);
 }
 
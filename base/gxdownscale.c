@@ -20,6 +20,9 @@
 #include "gdevprn.h"
 #include "assert_.h"
 #include "gsicc_cache.h"
+#include "gsparam.h"
+#include "gxdevsop.h"
+#include "gxsync.h"
 
 #ifdef WITH_CAL
 #include "cal_ets.h"
@@ -2242,6 +2245,384 @@ do_alloc_liner(gs_memory_t *mem, size_t size, const char *type,
     return 0;
 }
 
+/* Get the downfactor source lines for an output row into planes (each
+ * holding downfactor lines of span bytes), repeating the last line if we
+ * run off the bottom of the page. Returns the number of lines got (0 if
+ * the row is past the end of the page), or an error. */
+static int
+downscaler_fetch_planar(gx_downscaler_t *ds, byte **planes, int row)
+{
+    gs_get_bits_params_t params2;
+    int                  copy = (ds->dev->width * ds->src_bpc + 7)>>3;
+    int                  upfactor, downfactor;
+    int                  y, i, j, code;
+
+    gx_downscaler_decode_factor(ds->factor, &upfactor, &downfactor);
+
+    /* We always work a line at a time. */
+    y = (row/upfactor) * downfactor;
+    for (i = 0; i < downfactor && y < ds->dev->height; i++, y++) {
+        /* Copy the params, because get_bits_rectangle can helpfully
+         * overwrite them. */
+        memcpy(&params2, &ds->params, sizeof(params2));
+        for (j = 0; j < ds->num_planes; j++)
+            params2.data[j] = planes[j] + i * ds->span;
+        code = ds->liner->get_line(ds->liner, &params2, y);
+        if (code < 0)
+            return code;
+        for (j = 0; j < ds->num_planes; j++) {
+            byte *tgt = planes[j] + i * ds->span;
+            if (params2.data[j] != tgt)
+                memcpy(tgt, params2.data[j], copy);
+        }
+    }
+    if (i == 0)
+        return 0;
+    for (y = i; y < downfactor; y++)
+        for (j = 0; j < ds->num_planes; j++)
+            memcpy(planes[j] + y*ds->span, planes[j] + (y-1)*ds->span, copy);
+
+    return i;
+}
+
+/* Chunky equivalent of the above, for the getbits case. */
+static int
+downscaler_fetch_chunky(gx_downscaler_t *ds, byte *data, int row)
+{
+    int upfactor, downfactor;
+    int y, y_end, code;
+
+    gx_downscaler_decode_factor(ds->factor, &upfactor, &downfactor);
+
+    y     = row * downfactor;
+    y_end = y + downfactor;
+    do {
+        code = ds->liner->get_line(ds->liner, data, y);
+        if (code < 0)
+            return code;
+        data += ds->span;
+        y++;
+    } while (y < y_end);
+
+    return 0;
+}
+
+/*
+ * Error diffusion, MinFeatureSize and ETS carry state from one row to the
+ * next, and trapping needs rows either side, so none of them can be split
+ * up by band. What we can do is give down_core threads of its own: the
+ * caller's thread gets the source lines (rendering the bands, trapping)
+ * and writes out the results, while the workers run a few rows behind it.
+ *
+ * Nor can the rows be skewed across threads (a wavefront) without
+ * changing the output: the error diffusion cores alternate direction
+ * from row to row, and ETS finishes each row with a right to left pass,
+ * so the start of one row depends on the end of the one before. In the
+ * planar case, though, each plane has its own errors (and MinFeatureSize
+ * data), so the planes are shared out between several workers.
+ *
+ * We take the device having been asked for rendering threads as our cue
+ * (and use no more workers than that), and only pipeline the cases that
+ * are down_core and nothing else (no color management, no upscaling).
+ * Rows must be asked for in order, as every caller does; if not, the pipe
+ * is stopped and we carry on synchronously.
+ */
+#define DOWNSCALER_PIPE_DEPTH 8
+#define DOWNSCALER_PIPE_MAX_WORKERS 8
+
+typedef struct downscaler_pipe_slot_s
+{
+    int   row;
+    int   code;                 /* From getting the source lines */
+    bool  quit;                 /* Tells the workers to exit */
+    byte *in[GS_CLIENT_COLOR_MAX_COMPONENTS];
+    byte *out;
+} downscaler_pipe_slot_t;
+
+typedef struct downscaler_pipe_worker_s
+{
+    struct gx_downscaler_pipe_s *pipe;
+    int             first_plane;/* Does first_plane, first_plane + num_workers... */
+    gx_semaphore_t *work;       /* Signalled once per slot queued */
+    gx_semaphore_t *done;       /* Signalled once per slot finished */
+    gp_thread_id    thread;
+} downscaler_pipe_worker_t;
+
+typedef struct gx_downscaler_pipe_s
+{
+    gx_downscaler_t *ds;
+    int              num_workers;
+    downscaler_pipe_worker_t worker[DOWNSCALER_PIPE_MAX_WORKERS];
+    int              height;    /* Number of output rows */
+    int              queued;    /* Next row to queue */
+    int              taken;     /* Next row the caller should ask for */
+    int              out_span;  /* Per plane, in the slot */
+    int              out_size;  /* Per plane, as returned to the caller */
+    byte            *data_alloc;
+    downscaler_pipe_slot_t slot[DOWNSCALER_PIPE_DEPTH];
+} gx_downscaler_pipe_t;
+
+static void
+downscaler_pipe_worker(void *arg)
+{
+    downscaler_pipe_worker_t *worker = (downscaler_pipe_worker_t *)arg;
+    gx_downscaler_pipe_t     *pipe = worker->pipe;
+    gx_downscaler_t          *ds = pipe->ds;
+    int                       n, plane;
+
+    for (n = 0; ; n = (n+1) % DOWNSCALER_PIPE_DEPTH) {
+        downscaler_pipe_slot_t *slot = &pipe->slot[n];
+
+        gx_semaphore_wait(worker->work);
+        if (slot->quit)
+            break;
+        if (slot->code >= 0) {
+            if (ds->num_planes == 0)
+                (ds->down_core)(ds, slot->out, slot->in[0], slot->row, 0,
+                                ds->span);
+            else
+                for (plane = worker->first_plane; plane < ds->num_planes;
+                     plane += pipe->num_workers)
+                    (ds->down_core)(ds, slot->out + plane * pipe->out_span,
+                                    slot->in[plane], slot->row, plane,
+                                    ds->span);
+        }
+        gx_semaphore_signal(worker->done);
+    }
+}
+
+/* Get the source lines for the next row and hand them to the workers. */
+static void
+downscaler_pipe_queue(gx_downscaler_pipe_t *pipe)
+{
+    gx_downscaler_t        *ds = pipe->ds;
+    downscaler_pipe_slot_t *slot = &pipe->slot[pipe->queued % DOWNSCALER_PIPE_DEPTH];
+    int                     i;
+
+    slot->row = pipe->queued++;
+    if (ds->num_planes == 0)
+        slot->code = downscaler_fetch_chunky(ds, slot->in[0], slot->row);
+    else
+        slot->code = downscaler_fetch_planar(ds, slot->in, slot->row);
+    for (i = 0; i < pipe->num_workers; i++)
+        gx_semaphore_signal(pipe->worker[i].work);
+}
+
+/* Wait for the workers to finish the next row. */
+static void
+downscaler_pipe_wait(gx_downscaler_pipe_t *pipe)
+{
+    int i;
+
+    for (i = 0; i < pipe->num_workers; i++)
+        gx_semaphore_wait(pipe->worker[i].done);
+    pipe->taken++;
+}
+
+static void
+downscaler_pipe_free(gx_downscaler_pipe_t *pipe)
+{
+    gs_memory_t *mem = pipe->ds->dev->memory;
+    int          i;
+
+    for (i = 0; i < DOWNSCALER_PIPE_MAX_WORKERS; i++) {
+        if (pipe->worker[i].work)
+            gx_semaphore_free(pipe->worker[i].work);
+        if (pipe->worker[i].done)
+            gx_semaphore_free(pipe->worker[i].done);
+    }
+    gs_free_object(mem, pipe->data_alloc, "gx_downscaler(pipe data)");
+    gs_free_object(mem, pipe, "gx_downscaler(pipe)");
+}
+
+/* Tell the (first n) workers to exit, and wait for them. */
+static void
+downscaler_pipe_quit(gx_downscaler_pipe_t *pipe, int n)
+{
+    int i;
+
+    pipe->slot[pipe->queued % DOWNSCALER_PIPE_DEPTH].quit = true;
+    for (i = 0; i < n; i++)
+        gx_semaphore_signal(pipe->worker[i].work);
+    for (i = 0; i < n; i++)
+        gp_thread_finish(pipe->worker[i].thread);
+}
+
+static void
+downscaler_pipe_stop(gx_downscaler_t *ds)
+{
+    gx_downscaler_pipe_t *pipe = ds->pipe;
+
+    if (pipe == NULL)
+        return;
+    ds->pipe = NULL;
+
+    /* Let the workers get through what they have, so that the next slot
+     * is free for the message to quit. */
+    while (pipe->taken < pipe->queued)
+        downscaler_pipe_wait(pipe);
+    downscaler_pipe_quit(pipe, pipe->num_workers);
+    downscaler_pipe_free(pipe);
+}
+
+/* Returns 1 if the pipe has been stopped, and the caller should do the
+ * row itself. */
+static int
+downscaler_pipe_get(gx_downscaler_t *ds, byte **out, int row)
+{
+    gx_downscaler_pipe_t   *pipe = ds->pipe;
+    downscaler_pipe_slot_t *slot;
+    int                     code, plane;
+
+    if (row != pipe->taken) {
+        downscaler_pipe_stop(ds);
+        return 1;
+    }
+
+    /* Fill the pipe (only does anything on the first row). */
+    while (pipe->queued < pipe->taken + DOWNSCALER_PIPE_DEPTH &&
+           pipe->queued < pipe->height)
+        downscaler_pipe_queue(pipe);
+
+    slot = &pipe->slot[row % DOWNSCALER_PIPE_DEPTH];
+    downscaler_pipe_wait(pipe);
+    code = slot->code;
+    if (code >= 0) {
+        code = 0;
+        if (ds->num_planes == 0)
+            memcpy(out[0], slot->out, pipe->out_size);
+        else
+            for (plane = 0; plane < ds->num_planes; plane++)
+                memcpy(out[plane], slot->out + plane * pipe->out_span,
+                       pipe->out_size);
+    }
+
+    /* The slot is free again; refill it so that the workers carry on
+     * while our caller deals with this row. */
+    if (pipe->queued < pipe->height)
+        downscaler_pipe_queue(pipe);
+
+    return code;
+}
+
+/* How many rendering threads the device has been asked for. */
+static int
+downscaler_rendering_threads(gx_device *dev)
+{
+    char data[] = "NumRenderingThreads";
+    dev_param_req_t request;
+    gs_c_param_list list;
+    int nthreads = 0;
+    int code;
+
+    gs_c_param_list_write(&list, dev->memory);
+    /* Stuff the data into a structure for passing to the spec_op */
+    request.Param = data;
+    request.list = &list;
+    code = dev_proc(dev, dev_spec_op)(dev, gxdso_get_dev_param, &request, sizeof(dev_param_req_t));
+    if (code < 0) {
+        gs_c_param_list_release(&list);
+        return 0;
+    }
+    gs_c_param_list_read(&list);
+    code = param_read_int((gs_param_list *)&list,
+            "NumRenderingThreads",
+            &nthreads);
+    gs_c_param_list_release(&list);
+    if (code != 0)
+        return 0;
+
+    return nthreads;
+}
+
+/* Called at the end of a successful init. Failing to start the pipe is
+ * not an error; we just run synchronously. */
+static void
+downscaler_pipe_start(gx_downscaler_t *ds)
+{
+    gs_memory_t          *mem = ds->dev->memory;
+    gx_downscaler_pipe_t *pipe;
+    int                   upfactor, downfactor;
+    int                   num_planes = ds->num_planes ? ds->num_planes : 1;
+    int                   num_workers;
+    size_t                in_size, out_span, slot_size;
+    byte                 *data;
+    int                   i, j;
+
+    if (ds->down_core == NULL || ds->apply_cm != NULL)
+        return;
+    gx_downscaler_decode_factor(ds->factor, &upfactor, &downfactor);
+    if (upfactor != 1)
+        return;
+    num_workers = downscaler_rendering_threads(ds->dev);
+    if (num_workers <= 0)
+        return;
+    if (num_workers > num_planes)
+        num_workers = num_planes;
+    if (num_workers > DOWNSCALER_PIPE_MAX_WORKERS)
+        num_workers = DOWNSCALER_PIPE_MAX_WORKERS;
+
+    pipe = (gx_downscaler_pipe_t *)gs_alloc_bytes(mem, sizeof(*pipe),
+                                                  "gx_downscaler(pipe)");
+    if (pipe == NULL)
+        return;
+    memset(pipe, 0, sizeof(*pipe));
+    pipe->ds = ds;
+    pipe->height = (ds->dev->height + downfactor-1) / downfactor;
+    if (ds->num_planes)
+        pipe->out_size = (ds->width * ds->dst_bpc + 7)>>3;
+    else
+        pipe->out_size = (ds->awidth * ds->num_comps * ds->dst_bpc + 7)>>3;
+
+    /* Keep everything 32 byte aligned, as the halftoning cores like. */
+    in_size = ((size_t)ds->span * downfactor + 31) & ~31;
+    out_span = ((size_t)pipe->out_size + 64 + 31) & ~31;
+    pipe->out_span = (int)out_span;
+    slot_size = (in_size + out_span) * num_planes;
+    pipe->data_alloc = gs_alloc_bytes(mem, slot_size * DOWNSCALER_PIPE_DEPTH + 32,
+                                      "gx_downscaler(pipe data)");
+    if (pipe->data_alloc == NULL) {
+        downscaler_pipe_free(pipe);
+        return;
+    }
+    data = pipe->data_alloc + ((32-(intptr_t)pipe->data_alloc) & 31);
+    for (i = 0; i < DOWNSCALER_PIPE_DEPTH; i++) {
+        for (j = 0; j < num_planes; j++, data += in_size)
+            pipe->slot[i].in[j] = data;
+        pipe->slot[i].out = data;
+        data += out_span * num_planes;
+    }
+
+    for (i = 0; i < num_workers; i++) {
+        downscaler_pipe_worker_t *worker = &pipe->worker[i];
+
+        worker->pipe = pipe;
+        worker->first_plane = i;
+        worker->work = gx_semaphore_label(gx_semaphore_alloc(mem), "downscaler work");
+        worker->done = gx_semaphore_label(gx_semaphore_alloc(mem), "downscaler done");
+        if (worker->work == NULL || worker->done == NULL)
+            break;
+    }
+    if (i < num_workers) {
+        downscaler_pipe_free(pipe);
+        return;
+    }
+    pipe->num_workers = num_workers;
+    for (i = 0; i < num_workers; i++) {
+        if (gp_thread_start(downscaler_pipe_worker, &pipe->worker[i],
+                            &pipe->worker[i].thread) < 0)
+            break;
+        gp_thread_label(pipe->worker[i].thread, "Downscale");
+    }
+    if (i < num_workers) {
+        /* Stop the ones we did start (nothing has been queued). */
+        downscaler_pipe_quit(pipe, i);
+        downscaler_pipe_free(pipe);
+        return;
+    }
+    ds->pipe = pipe;
+}
+
 int gx_downscaler_init_planar_cm(gx_downscaler_t      *ds,
                                  gx_device            *dev,
                                  int                   src_bpc,
@@ -2523,6 +2904,7 @@ int gx_downscaler_init_planar_cm(gx_downscaler_t      *ds,
         memset(ds->errors, 0, (size_t)num_comps * (width+3) * sizeof(int));
     }
 
+    downscaler_pipe_start(ds);
     return 0;
 
   cleanup:
@@ -2918,6 +3300,7 @@ gx_downscaler_init_cm_halftone(gx_downscaler_t      *ds,
         }
     }
 
+    downscaler_pipe_start(ds);
     return 0;
 
   cleanup:
@@ -2930,6 +3313,8 @@ void gx_downscaler_fin(gx_downscaler_t *ds)
     if (ds->dev == NULL)
         return;
 
+    downscaler_pipe_stop(ds);
+
     gs_free_object(ds->dev->memory, ds->pre_cm[0],
                    "gx_downscaler(planar_data)");
     gs_free_object(ds->dev->memory, ds->post_cm[0],
@@ -2963,11 +3348,7 @@ int gx_downscaler_getbits(gx_downscaler_t *ds,
                           int              row)
 {
     int   code = 0;
-    int   y, y_end;
     byte *data_ptr;
-    int   upfactor, downfactor;
-
-    gx_downscaler_decode_factor(ds->factor, &upfactor, &downfactor);
 
     /* Check for the simple case */
     if (ds->down_core == NULL) {
@@ -2983,17 +3364,16 @@ int gx_downscaler_getbits(gx_downscaler_t *ds,
         return 0;
     }
 
-    /* Get factor rows worth of data */
-    y        = row * downfactor;
-    y_end    = y + downfactor;
-    data_ptr = ds->pre_cm[0];
-    do {
-        code = ds->liner->get_line(ds->liner, data_ptr, y);
-        if (code < 0)
+    if (ds->pipe) {
+        code = downscaler_pipe_get(ds, &out_data, row);
+        if (code <= 0)
             return code;
-        data_ptr += ds->span;
-        y++;
-    } while (y < y_end);
+    }
+
+    /* Get factor rows worth of data */
+    code = downscaler_fetch_chunky(ds, ds->pre_cm[0], row);
+    if (code < 0)
+        return code;
 
     if (ds->apply_cm) {
         if (ds->early_cm) {
@@ -3026,14 +3406,9 @@ int gx_downscaler_get_bits_rectangle(gx_downscaler_t      *ds,
     gs_get_bits_params_t  params2;
     int                   upfactor, downfactor;
     int                   subrow;
-    int                   copy = (ds->dev->width * ds->src_bpc + 7)>>3;
-    int                   i, j, n;
+    int                   i, j;
     int                   num_planes_to_downscale;
 
-    n = ds->dev->width;
-
-    n = (n*ds->src_bpc+7)/8;
-
     gx_downscaler_decode_factor(factor, &upfactor, &downfactor);
 
     subrow = row % upfactor;
@@ -3078,44 +3453,23 @@ int gx_downscaler_get_bits_rectangle(gx_downscaler_t      *ds,
         return code;
     }
 
-    /* Copy the params, because get_bits_rectangle can helpfully overwrite
-     * them. */
-    memcpy(&params2, &ds->params, sizeof(params2));
-    for (i = 0; i < ds->num_planes; i++)
-         params2.data[i] = ds->pre_cm[i];
-
-    /* Get downfactor rows worth of data - we always work a line at a
-     * time now. */
-    for (i = 0; i < downfactor; i++) {
-        rect.q.y = rect.p.y+1;
-        if (rect.q.y > ds->dev->height)
-            break;
-        memcpy(&params2, &ds->params, sizeof(params2));
-        for (j = 0; j < ds->num_planes; j++)
-            params2.data[j] = ds->pre_cm[j] + i * ds->span;
-        code = ds->liner->get_line(ds->liner, &params2, rect.p.y);
-        if (code < 0)
-            break;
-        for (j = 0; j < ds->num_planes; j++) {
-            byte *tgt = ds->pre_cm[j] + i * ds->span;
-            if (params2.data[j] != tgt)
-                memcpy(tgt, params2.data[j], n);
-        }
-        rect.p.y++;
+    if (ds->pipe) {
+        code = downscaler_pipe_get(ds, params->data, row);
+        if (code <= 0)
+            return code;
     }
-    if (i == 0)
-        return code;
-    if (code < 0)
+
+    /* Get downfactor rows worth of data. If we've hit the end of the page
+     * the last line we did get is duplicated. */
+    code = downscaler_fetch_planar(ds, ds->pre_cm, row);
+    if (code <= 0)
         return code;
-    /* If we still haven't got enough, we've hit the end of the page; just
-     * duplicate the last line we did get. */
-    for (; i < downfactor; i++)
-        for (j = 0; j < ds->num_planes; j++)
-            memcpy(ds->pre_cm[j] + i*ds->span, ds->pre_cm[j] + (i-1)*ds->span, copy);
+    code = 0;
 
     /* All the data is now in ds->pre_cm. Update params2.data so that this points to
      * it. From here on in, we will keep params2.data pointing to whereever the
      * latest processed version of the data is. */
+    memcpy(&params2, &ds->params, sizeof(params2));
     for (j = 0; j < ds->num_planes; j++)
         params2.data[j] = ds->pre_cm[j];
 
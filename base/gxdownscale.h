@@ -111,6 +111,9 @@ struct gx_downscaler_s {
     int                   do_skew_detection;
     int                   skew_detected;
     double                skew_angle;
+
+    struct gx_downscaler_pipe_s *pipe; /* Thread running down_core ahead
+                                        * of the caller, or NULL */
 };
 
 /* The following structure is used to hold the configuration
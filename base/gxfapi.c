@@ -36,6 +36,7 @@
 #include "gsbittab.h"
 #include "gzpath.h"
 #include "gxdevsop.h"
+#include "gstrace.h"
 
 #include "gxfapi.h"
 
@@ -1266,6 +1267,7 @@ gs_fapi_do_char(gs_font *pfont, gs_gstate *pgs, gs_text_enum_t *penum, char *fon
     double em_scale_x, em_scale_y;
     gs_rect char_bbox;
     int code;
+    int64_t start;
     bool imagenow = false;
     bool align_to_pixels = gs_currentaligntopixels(pbfont->dir);
     gs_memory_t *mem = pfont->memory;
@@ -1591,6 +1593,7 @@ retry_scaling:
         }
     }
     memset(&metrics, 0x00, sizeof(metrics));
+    start = gs_trace_begin(mem);
     /* Take metrics from font : */
     if (I->ff.metrics_only) {
         code = I->get_char_outline_metrics(I, &I->ff, &cr, &metrics);
@@ -1617,6 +1620,7 @@ retry_scaling:
             code = I->get_char_outline_metrics(I, &I->ff, &cr, &metrics);
         }
     }
+    gs_trace_end(mem, start, "font", "render_glyph", (int64_t)chr);
 
     /* This handles the situation where a charstring has been replaced with a PS procedure.
      * against the rules, but not *that* rare.
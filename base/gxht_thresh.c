@@ -102,27 +102,7 @@ gx_ht_threshold_row_byte(byte *contone, byte *threshold_strip, int contone_strid
 }
 #endif
 
-#ifndef HAVE_SSE2
-/* A simple case for use in the landscape mode. Could probably be coded up
-   faster */
-static void
-threshold_16_bit(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
-{
-    int j;
-
-    for (j = 2; j > 0; j--) {
-        byte h = 0;
-        byte bit_init = 0x80;
-        do {
-            if (*contone_ptr++ < *thresh_ptr++) {
-                h |=  bit_init;
-            }
-            bit_init >>= 1;
-        } while (bit_init != 0);
-        *ht_data++ = h;
-    }
-}
-#else
+#ifdef HAVE_SSE2
 /* Note this function has strict data alignment needs */
 static void
 threshold_16_SSE(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
@@ -176,6 +156,101 @@ threshold_16_SSE_unaligned(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
     ht_data[0] = bitreverse[sse_data[0]];
     ht_data[1] = bitreverse[sse_data[1]];
 }
+
+#define THRESHOLD_16_SIMD
+#define threshold_16_simd(C, T, H) threshold_16_SSE(C, T, H)
+#define threshold_16_simd_unaligned(C, T, H) threshold_16_SSE_unaligned(C, T, H)
+
+/* With gcc and clang we can also build an AVX2 version, doing 32 at a
+   time, and pick it at run time if the CPU has it. */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define THRESHOLD_32_AVX2
+
+#include <immintrin.h>
+
+/* Same result as two calls to threshold_16_SSE_unaligned. */
+__attribute__((target("avx2"))) static void
+threshold_32_AVX2(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    __m256i input1;
+    __m256i input2;
+    unsigned int result_int;
+    const __m256i sign_fix = _mm256_set1_epi8((char)0x80);
+    /* Reverses each group of 8 bytes, so that the movemask comes out in
+       the bit order we want, without the table */
+    const __m256i reverse = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                                            0, 1, 2, 3, 4, 5, 6, 7,
+                                            8, 9, 10, 11, 12, 13, 14, 15,
+                                            0, 1, 2, 3, 4, 5, 6, 7);
+
+    input1 = _mm256_loadu_si256((const __m256i *)contone_ptr);
+    input2 = _mm256_loadu_si256((const __m256i *)thresh_ptr);
+    input1 = _mm256_xor_si256(input1, sign_fix);
+    input2 = _mm256_xor_si256(input2, sign_fix);
+    /* 0xff where contone < thresh */
+    input2 = _mm256_cmpgt_epi8(input2, input1);
+    input2 = _mm256_shuffle_epi8(input2, reverse);
+    result_int = (unsigned int)_mm256_movemask_epi8(input2);
+    ht_data[0] = (byte)result_int;
+    ht_data[1] = (byte)(result_int >> 8);
+    ht_data[2] = (byte)(result_int >> 16);
+    ht_data[3] = (byte)(result_int >> 24);
+}
+
+static int
+threshold_use_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+/* NEON is always there on 64 bit ARM, so no need for a run time check. */
+#include <arm_neon.h>
+
+static void
+threshold_16_NEON(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    static const byte bit_values[16] =
+        { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+          0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    uint8x16_t result;
+
+    /* 0xff where contone < thresh, then keep the bit for each position
+       and add them up for each half */
+    result = vcltq_u8(vld1q_u8(contone_ptr), vld1q_u8(thresh_ptr));
+    result = vandq_u8(result, vld1q_u8(bit_values));
+    ht_data[0] = vaddv_u8(vget_low_u8(result));
+    ht_data[1] = vaddv_u8(vget_high_u8(result));
+}
+
+#define THRESHOLD_16_SIMD
+#define threshold_16_simd(C, T, H) threshold_16_NEON(C, T, H)
+#define threshold_16_simd_unaligned(C, T, H) threshold_16_NEON(C, T, H)
+#endif
+
+#ifndef THRESHOLD_16_SIMD
+/* A simple case for use in the landscape mode. Could probably be coded up
+   faster */
+static void
+threshold_16_bit(byte *contone_ptr, byte *thresh_ptr, byte *ht_data)
+{
+    int j;
+
+    for (j = 2; j > 0; j--) {
+        byte h = 0;
+        byte bit_init = 0x80;
+        do {
+            if (*contone_ptr++ < *thresh_ptr++) {
+                h |=  bit_init;
+            }
+            bit_init >>= 1;
+        } while (bit_init != 0);
+        *ht_data++ = h;
+    }
+}
 #endif
 
 /* SSE2 and non-SSE2 implememntation of thresholding a row. Subtractive case
@@ -187,7 +262,7 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
                   byte *halftone, int dithered_stride, int width,
                   int num_rows, int offset_bits)
 {
-#ifndef HAVE_SSE2
+#ifndef THRESHOLD_16_SIMD
     int k, j;
     byte *contone_ptr;
     byte *thresh_ptr;
@@ -253,6 +328,9 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
     int k, j;
+#ifdef THRESHOLD_32_AVX2
+    int avx2 = threshold_use_avx2();
+#endif
 
     for (j = 0; j < num_rows; j++) {
         /* contone and thresh_ptr are 128 bit aligned.  We do need to do this in
@@ -267,8 +345,8 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
                requires 128 bit alignment.  contone_ptr and thresh_ptr
                are set up so that after we move in by offset_bits elements
                then we are 128 bit aligned.  */
-            threshold_16_SSE_unaligned(thresh_ptr, contone_ptr,
-                                       halftone_ptr);
+            threshold_16_simd_unaligned(thresh_ptr, contone_ptr,
+                                        halftone_ptr);
             halftone_ptr += 2;
             thresh_ptr += offset_bits;
             contone_ptr += offset_bits;
@@ -276,8 +354,19 @@ gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,  int contone_
         /* Now we should have 128 bit aligned with our input data. Iterate
            over sets of 16 going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
-            threshold_16_SSE(thresh_ptr, contone_ptr, halftone_ptr);
+        k = num_tiles;
+#ifdef THRESHOLD_32_AVX2
+        if (avx2) {
+            for (; k >= 2; k -= 2) {
+                threshold_32_AVX2(thresh_ptr, contone_ptr, halftone_ptr);
+                thresh_ptr += 32;
+                contone_ptr += 32;
+                halftone_ptr += 4;
+            }
+        }
+#endif
+        for (; k > 0; k--) {
+            threshold_16_simd(thresh_ptr, contone_ptr, halftone_ptr);
             thresh_ptr += 16;
             contone_ptr += 16;
             halftone_ptr += 2;
@@ -292,7 +381,7 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
                   byte *halftone, int dithered_stride, int width,
                   int num_rows, int offset_bits)
 {
-#ifndef HAVE_SSE2
+#ifndef THRESHOLD_16_SIMD
     int k, j;
     byte *contone_ptr;
     byte *thresh_ptr;
@@ -358,6 +447,9 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
     byte *halftone_ptr;
     int num_tiles = (width - offset_bits + 15)>>4;
     int k, j;
+#ifdef THRESHOLD_32_AVX2
+    int avx2 = threshold_use_avx2();
+#endif
 
     for (j = 0; j < num_rows; j++) {
         /* contone and thresh_ptr are 128 bit aligned.  We do need to do this in
@@ -372,8 +464,8 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
                requires 128 bit alignment.  contone_ptr and thresh_ptr
                are set up so that after we move in by offset_bits elements
                then we are 128 bit aligned.  */
-            threshold_16_SSE_unaligned(contone_ptr, thresh_ptr,
-                                       halftone_ptr);
+            threshold_16_simd_unaligned(contone_ptr, thresh_ptr,
+                                        halftone_ptr);
             halftone_ptr += 2;
             thresh_ptr += offset_bits;
             contone_ptr += offset_bits;
@@ -381,8 +473,19 @@ gx_ht_threshold_row_bit(byte *contone,  byte *threshold_strip,  int contone_stri
         /* Now we should have 128 bit aligned with our input data. Iterate
            over sets of 16 going directly into our HT buffer.  Sources and
            halftone_ptr buffers should be padded to allow 15 bit overrun */
-        for (k = 0; k < num_tiles; k++) {
-            threshold_16_SSE(contone_ptr, thresh_ptr, halftone_ptr);
+        k = num_tiles;
+#ifdef THRESHOLD_32_AVX2
+        if (avx2) {
+            for (; k >= 2; k -= 2) {
+                threshold_32_AVX2(contone_ptr, thresh_ptr, halftone_ptr);
+                thresh_ptr += 32;
+                contone_ptr += 32;
+                halftone_ptr += 4;
+            }
+        }
+#endif
+        for (; k > 0; k--) {
+            threshold_16_simd(contone_ptr, thresh_ptr, halftone_ptr);
             thresh_ptr += 16;
             contone_ptr += 16;
             halftone_ptr += 2;
@@ -408,6 +511,9 @@ gx_ht_threshold_landscape_sub(byte *contone_align, byte *thresh_align,
 #ifdef PACIFY_VALGRIND
     int extra = 0;
 #endif
+#if LAND_BITS > 16 && defined(THRESHOLD_32_AVX2)
+    int avx2 = threshold_use_avx2();
+#endif
 
     /* Work through chunks of 16.  */
     /* Data may have come in left to right or right to left. */
@@ -463,10 +569,23 @@ gx_ht_threshold_landscape_sub(byte *contone_align, byte *thresh_align,
         contone_ptr = &contone[0];
 #if LAND_BITS > 16
         j = LAND_BITS;
+#if defined(THRESHOLD_32_AVX2)
+        if (avx2) {
+            do {
+                threshold_32_AVX2(thresh_ptr, contone_ptr, halftone_ptr);
+                thresh_ptr += 32;
+                position += 32;
+                halftone_ptr += 4;
+                contone_ptr += 32;
+                j -= 32;
+            } while (j >= 32);
+        }
+        if (j > 0)
+#endif
         do {
 #endif
-#ifdef HAVE_SSE2
-            threshold_16_SSE(thresh_ptr, contone_ptr, halftone_ptr);
+#ifdef THRESHOLD_16_SIMD
+            threshold_16_simd(thresh_ptr, contone_ptr, halftone_ptr);
 #else
             threshold_16_bit(thresh_ptr, contone_ptr, halftone_ptr);
 #endif
@@ -499,6 +618,9 @@ gx_ht_threshold_landscape(byte *contone_align, byte *thresh_align,
 #ifdef PACIFY_VALGRIND
     int extra = 0;
 #endif
+#if LAND_BITS > 16 && defined(THRESHOLD_32_AVX2)
+    int avx2 = threshold_use_avx2();
+#endif
 
     /* Work through chunks of 16.  */
     /* Data may have come in left to right or right to left. */
@@ -554,10 +676,23 @@ gx_ht_threshold_landscape(byte *contone_align, byte *thresh_align,
         contone_ptr = &contone[0];
 #if LAND_BITS > 16
         j = LAND_BITS;
+#if defined(THRESHOLD_32_AVX2)
+        if (avx2) {
+            do {
+                threshold_32_AVX2(contone_ptr, thresh_ptr, halftone_ptr);
+                thresh_ptr += 32;
+                position += 32;
+                halftone_ptr += 4;
+                contone_ptr += 32;
+                j -= 32;
+            } while (j >= 32);
+        }
+        if (j > 0)
+#endif
         do {
 #endif
-#ifdef HAVE_SSE2
-            threshold_16_SSE(contone_ptr, thresh_ptr, halftone_ptr);
+#ifdef THRESHOLD_16_SIMD
+            threshold_16_simd(contone_ptr, thresh_ptr, halftone_ptr);
 #else
             threshold_16_bit(contone_ptr, thresh_ptr, halftone_ptr);
 #endif
@@ -799,14 +799,7 @@ tile_rect_trans_simple(int xmin, int ymin, int xmax, int ymax,
 
     /* Update the bbox in the topmost stack entry to reflect the fact that we
      * have drawn into it. FIXME: This makes the groups too large! */
-    if (buf->dirty.p.x > xmin)
-        buf->dirty.p.x = xmin;
-    if (buf->dirty.p.y > ymin)
-        buf->dirty.p.y = ymin;
-    if (buf->dirty.q.x < xmax)
-        buf->dirty.q.x = xmax;
-    if (buf->dirty.q.y < ymax)
-        buf->dirty.q.y = ymax;
+    pdf14_buf_mark_dirty(buf, xmin, ymin, xmax, ymax);
     buff_out_y_offset = ymin - fill_trans_buffer->rect.p.y;
     buff_out_x_offset = xmin - fill_trans_buffer->rect.p.x;
 
@@ -1288,14 +1281,7 @@ tile_rect_trans_blend(int xmin, int ymin, int xmax, int ymax,
 
     /* Update the bbox in the topmost stack entry to reflect the fact that we
      * have drawn into it. FIXME: This makes the groups too large! */
-    if (buf->dirty.p.x > xmin)
-        buf->dirty.p.x = xmin;
-    if (buf->dirty.p.y > ymin)
-        buf->dirty.p.y = ymin;
-    if (buf->dirty.q.x < xmax)
-        buf->dirty.q.x = xmax;
-    if (buf->dirty.q.y < ymax)
-        buf->dirty.q.y = ymax;
+    pdf14_buf_mark_dirty(buf, xmin, ymin, xmax, ymax);
 
     if (!ptile->ttrans->deep)
         do_tile_rect_trans_blend(xmin, ymin, xmax, ymax,
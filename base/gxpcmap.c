@@ -42,6 +42,7 @@
 #include "gscoord.h"
 #include "gsicc_blacktext.h"
 #include "gscspace.h"
+#include "gsmemrep.h"
 
 #if RAW_PATTERN_DUMP
 unsigned int global_pat_index = 0;
@@ -991,6 +992,7 @@ gx_pattern_cache_free_entry(gx_pattern_cache * pcache, gx_color_tile * ctile, bo
 
         pcache->tiles_used--;
         pcache->bits_used -= ctile->bits_used;
+        gs_memreport_cache(mem, gs_memreport_pattern_cache, pcache->bits_used);
         ctile->id = gx_no_bitmap_id;
     }
 }
@@ -1068,6 +1070,7 @@ gx_pattern_cache_update_used(gs_gstate *pgs, size_t used)
 
     pcache->bits_used += used;
     pcache->tiles_used++;
+    gs_memreport_cache(pgs->memory, gs_memreport_pattern_cache, pcache->bits_used);
 }
 
 /*
@@ -144,7 +144,7 @@ JNIEXPORT jint JNICALL Java_com_artifex_gsjava_GSAPI_gsapi_1set_1display_1callba
 	if (idata->hasinit && idata->displayCallback)
 		storeDispalyHandle(idata);
 
-	display_callback *cb = new display_callback;
+	display_callback *cb = new display_callback();
 	cb->size = sizeof(display_callback);
 	cb->version_major = DISPLAY_VERSION_MAJOR;
 	cb->version_minor = DISPLAY_VERSION_MINOR;
@@ -162,6 +162,8 @@ JNIEXPORT jint JNICALL Java_com_artifex_gsjava_GSAPI_gsapi_1set_1display_1callba
 	cb->display_separation = callbacks::display::displaySeparationFunction;
 	cb->display_adjust_band_height = callbacks::display::displayAdjustBandHeightFunction;
 	cb->display_rectangle_request = callbacks::display::displayRectangleRequestFunction;
+	cb->display_band_alloc = NULL;
+	cb->display_band_ready = NULL;
 
 	int code = gsapi_set_display_callback((void *)instance, cb);
 	if (code == 0)
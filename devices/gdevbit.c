@@ -291,6 +291,8 @@ const gx_device_bit gs_bitrgbtags_device =
         false, /* bg_print_requested */
         0,     /* bg_print *  */
         0,     /* num_render_threads_requested */
+        0,     /* bg_print_pages */
+        0,     /* bg_print_memory */
         NULL,  /* saved_pages_list */
         {0}    /* save_procs_while_delaying_erasepage */
     };
@@ -168,6 +168,17 @@ static int display_alloc_bitmap(gx_device_display *, gx_device *);
 static int display_set_color_format(gx_device_display *dev, int nFormat);
 static int display_set_separations(gx_device_display *dev);
 static int display_raster(gx_device_display *dev);
+static int display_size_buf_device(gx_device_buf_space_t *space,
+                                   gx_device *target,
+                                   const gx_render_plane_t *render_plane,
+                                   int height, bool for_band);
+static int display_output_bands(gx_device_display *ddev, gx_device *dev);
+
+/* Does the caller take the page in bands, rendered into its own memory? */
+#define DISPLAY_BAND_DELIVERY(ddev)\
+    ((ddev)->callback->version_major > DISPLAY_VERSION_MAJOR_V3 &&\
+     (ddev)->callback->display_band_alloc != NULL &&\
+     (ddev)->callback->display_band_ready != NULL)
 
 /* Open the display driver. */
 static int
@@ -307,7 +318,10 @@ display_output_page(gx_device * dev, int copies, int flush)
     while(dev->parent)
         dev = dev->parent;
 
-    if (CLIST_MUTATABLE_HAS_MUTATED(ddev)) {
+    if (CLIST_MUTATABLE_HAS_MUTATED(ddev) && DISPLAY_BAND_DELIVERY(ddev)) {
+        /* Band delivery mode */
+        code = display_output_bands(ddev, dev);
+    } else if (CLIST_MUTATABLE_HAS_MUTATED(ddev)) {
         /* Rectangle request mode! */
         gs_get_bits_options_t options;
 
@@ -379,6 +393,76 @@ display_output_page(gx_device * dev, int copies, int flush)
     return code;
 }
 
+/*
+ * Render the page from the clist one band at a time, each straight into
+ * a block from the caller (by the same buffer device procs, and so with
+ * the same layout, as the page mode bitmap), and hand it back.
+ */
+static int
+display_output_bands(gx_device_display *ddev, gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)ddev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    gx_device_clist_common *cdev = (gx_device_clist_common *)ddev;
+    gx_device_buf_space_t buf_space;
+    gx_render_plane_t render_plane;
+    int band_height, y, h;
+    int code, code1;
+
+    code = clist_close_writer_and_init_reader(cldev);
+    if (code < 0)
+        return code;
+    band_height = crdev->page_info.band_params.BandHeight;
+    gx_render_plane_init(&render_plane, (gx_device *)ddev, -1);
+
+    for (y = 0; y < ddev->height; y += h) {
+        gx_device *bdev;
+        gs_int_rect band_rect;
+        void *mem;
+
+        h = min(band_height, ddev->height - y);
+        code = display_size_buf_device(&buf_space, (gx_device *)ddev,
+                                       NULL, h, true);
+        if (code < 0)
+            return code;
+        mem = ddev->callback->display_band_alloc(ddev->pHandle, dev, y, h,
+                                                 buf_space.bits);
+        if (mem == NULL)
+            return_error(gs_error_VMerror);
+
+        code = gdev_create_buf_device(cdev->buf_procs.create_buf_device,
+                                      &bdev, cdev->target, y, &render_plane,
+                                      ddev->memory,
+                                      &crdev->color_usage_array[y / band_height]);
+        if (code >= 0) {
+            /* Let setup_buf_device allocate the line pointers, so that
+             * the caller's block holds nothing but the bitmap. */
+            code = cdev->buf_procs.setup_buf_device(bdev, mem, buf_space.raster,
+                                                    NULL, 0, h, h);
+            band_rect.p.x = 0;
+            band_rect.p.y = y;
+            band_rect.q.x = ddev->width;
+            band_rect.q.y = y + h;
+            if (code >= 0)
+                code = clist_render_rectangle(cldev, &band_rect, bdev,
+                                              &render_plane, true);
+            cdev->buf_procs.destroy_buf_device(bdev);
+        }
+        /* Make any later get_bits render its band afresh. */
+        crdev->ymin = crdev->ymax = 0;
+        crdev->offset_map = NULL;
+
+        code1 = ddev->callback->display_band_ready(ddev->pHandle, dev, mem,
+                                                   y, code < 0 ? 0 : h,
+                                                   buf_space.raster);
+        if (code >= 0)
+            code = code1;
+        if (code < 0)
+            return code;
+    }
+    return 0;
+}
+
 /* Close the display driver */
 static int
 display_close(gx_device * dev)
@@ -1422,8 +1506,17 @@ static int display_check_structure(gx_device_display *ddev)
         if (ddev->callback->version_minor > DISPLAY_VERSION_MINOR_V2)
             return_error(gs_error_rangecheck);
     }
+    else if (ddev->callback->size == sizeof(struct display_callback_v3_s)) {
+        /* V3 structure with added banding callbacks */
+        if (ddev->callback->version_major != DISPLAY_VERSION_MAJOR_V3)
+            return_error(gs_error_rangecheck);
+
+        /* complain if caller asks for newer features */
+        if (ddev->callback->version_minor > DISPLAY_VERSION_MINOR_V3)
+            return_error(gs_error_rangecheck);
+    }
     else {
-        /* V3 structure with added display_separation callback */
+        /* V4 structure with added band delivery callbacks */
         if (ddev->callback->size != sizeof(display_callback))
             return_error(gs_error_rangecheck);
 
@@ -1730,7 +1823,8 @@ display_alloc_bitmap(gx_device_display * ddev, gx_device * param_dev)
         /* Bitmap failed to allocate. Can we recover by using rectangle
          * request mode? */
         if (ddev->callback->version_major <= DISPLAY_VERSION_MAJOR_V2 ||
-            ddev->callback->display_rectangle_request == NULL) {
+            (ddev->callback->display_rectangle_request == NULL &&
+             !DISPLAY_BAND_DELIVERY(ddev))) {
             /* No. Hard fail. */
             ddev->width = 0;
             ddev->height = 0;
@@ -88,6 +88,12 @@
  *  presize, display_choose_mode, {rectangle_request}*
  *  preclose, close
  *
+ * In the band delivery mode (V4, display_band_alloc and
+ * display_band_ready supplied, and display_memalloc returning NULL):
+ *  open, presize, display_choose_mode, {band_alloc, band_ready}*
+ *  presize, display_choose_mode, {band_alloc, band_ready}*
+ *  preclose, close
+ *
  * In a run that mixed request-rectangle and pagemode:
  *  open, presize, display_choose_mode, memalloc, size, sync, page
  *  presize, display_choose_mode, memfree, {rectangle_request}*
@@ -96,7 +102,7 @@
  *  preclose, memfree, close
  */
 
-#define DISPLAY_VERSION_MAJOR 3
+#define DISPLAY_VERSION_MAJOR 4
 #define DISPLAY_VERSION_MINOR 0
 
 #define DISPLAY_VERSION_MAJOR_V1 1 /* before separation format was added */
@@ -105,6 +111,9 @@
 #define DISPLAY_VERSION_MAJOR_V2 2 /* before planar and banding were added */
 #define DISPLAY_VERSION_MINOR_V2 0
 
+#define DISPLAY_VERSION_MAJOR_V3 3 /* before band delivery was added */
+#define DISPLAY_VERSION_MINOR_V3 0
+
 /* The display format is set by a combination of the following bitfields */
 
 /* Define the color space alternatives */
@@ -343,6 +352,64 @@ struct display_callback_s {
                                      void **memory, int *ox, int *oy,
                                      int *raster, int *plane_raster,
                                      int *x, int *y, int *w, int *h);
+
+    /* Added in V4 */
+    /* Band delivery mode. If both of these are non NULL, they are used
+     * instead of display_rectangle_request whenever the page mode
+     * bitmap could not be allocated (so a client that wants this mode
+     * should return NULL from display_memalloc). Each band of the page
+     * is then rendered straight into a block supplied by the client,
+     * and handed back to it, without any copying and without a full
+     * page bitmap.
+     *
+     * display_band_alloc is asked for a block of size bytes to hold
+     * lines y to y+h-1 of the page. The block is laid out exactly as
+     * the page mode bitmap would be for a page of h lines (same format,
+     * raster and plane order). Return NULL to abandon the page.
+     *
+     * display_band_ready is then called with the same block, once those
+     * lines have been rendered into it. raster is the number of bytes
+     * between the starts of successive lines (of all the planes for
+     * DISPLAY_PLANAR_INTERLEAVED). The block belongs to the client again
+     * as soon as it is called. If rendering the band failed, h is 0, and
+     * the contents are undefined. The bands are delivered in order, top
+     * to bottom, each display_band_alloc being followed by its
+     * display_band_ready.
+     */
+    void *(*display_band_alloc)(void *handle, void *device,
+                                int y, int h, size_t size);
+    int (*display_band_ready)(void *handle, void *device, void *memory,
+                              int y, int h, int raster);
+};
+
+/* This is the V3 structure, before band delivery was added */
+struct display_callback_v3_s {
+    int size; /* sizeof(struct display_callback_v3) */
+    int version_major; /* DISPLAY_VERSION_MAJOR_V3 */
+    int version_minor; /* DISPLAY_VERSION_MINOR_V3 */
+    int (*display_open)(void *handle, void *device);
+    int (*display_preclose)(void *handle, void *device);
+    int (*display_close)(void *handle, void *device);
+    int (*display_presize)(void *handle, void *device,
+        int width, int height, int raster, unsigned int format);
+    int (*display_size)(void *handle, void *device, int width, int height,
+        int raster, unsigned int format, unsigned char *pimage);
+    int (*display_sync)(void *handle, void *device);
+    int (*display_page)(void *handle, void *device, int copies, int flush);
+    int (*display_update)(void *handle, void *device, int x, int y,
+        int w, int h);
+    void *(*display_memalloc)(void *handle, void *device, size_t size);
+    int (*display_memfree)(void *handle, void *device, void *mem);
+    int (*display_separation)(void *handle, void *device,
+        int component, const char *component_name,
+        unsigned short c, unsigned short m,
+        unsigned short y, unsigned short k);
+    int (*display_adjust_band_height)(void *handle, void *device,
+                                      int bandheight);
+    int (*display_rectangle_request)(void *handle, void *device,
+                                     void **memory, int *ox, int *oy,
+                                     int *raster, int *plane_raster,
+                                     int *x, int *y, int *w, int *h);
 };
 
 /* This is the V2 structure, before banding and planar support was added */
@@ -49,6 +49,7 @@
  */
 /*#define PNG_NO_STDIO*/
 #include "png_.h"
+#include "zlib.h"
 
 #include "gdevprn.h"
 #include "gdevmem.h"
@@ -506,6 +507,244 @@ my_png_flush(png_struct *png)
     (void)gp_fflush(file);
 }
 
+/* ------ Compressing in the rendering threads ------ */
+
+/*
+ * When the page is rendered by several threads, the 8 bit per component
+ * formats skip libpng for the image data: each band is filtered and
+ * deflated by the thread which rendered it (as gdevfpng.c does) and the
+ * main thread just writes the bands out in order as IDAT chunks. libpng
+ * still writes everything before and after the image data.
+ *
+ * Each band is a separate raw deflate stream ending in a sync flush, so
+ * the bands can be joined into one zlib stream: the zlib header goes in
+ * front of the first band, and an empty final block and the Adler-32 of
+ * the whole of the data (combined from the bands' own) go at the end.
+ * The first line of each band can't use the line above it, so it uses
+ * the Sub filter; the others use Paeth.
+ */
+
+typedef struct png_band_arg_s {
+    png_struct *png_ptr;
+    int bpp;			/* bytes per pixel */
+    bool invert_alpha;
+    bool first;			/* no bands written yet */
+    uLong adler;		/* of the data written so far */
+} png_band_arg_t;
+
+typedef struct png_band_buffer_s {
+    uInt size;
+    uInt compressed;		/* not including the zlib header */
+    uLong adler;		/* of this band's data */
+    uLong length;		/* of this band's data, uncompressed */
+    byte data[1];		/* 2 bytes of zlib header, then the band */
+} png_band_buffer_t;
+
+static const byte png_zlib_header[2] = { 0x78, 0x9c };
+
+static int
+png_band_init_buffer(void *arg_, gx_device *dev, gs_memory_t *mem, int w, int h,
+                     void **pbuffer)
+{
+    png_band_arg_t *arg = (png_band_arg_t *)arg_;
+    png_band_buffer_t *buffer;
+    /* Worst case, plus room for the sync flush */
+    uLong size = deflateBound(NULL, ((uLong)w * arg->bpp + 1) * h) + 16;
+
+    buffer = (png_band_buffer_t *)gs_alloc_bytes(mem, sizeof(*buffer) + size,
+                                                 "png_band_init_buffer");
+    *pbuffer = buffer;
+    if (buffer == NULL)
+        return_error(gs_error_VMerror);
+    buffer->size = size;
+    buffer->compressed = 0;
+    memcpy(buffer->data, png_zlib_header, sizeof(png_zlib_header));
+    return 0;
+}
+
+static void
+png_band_free_buffer(void *arg, gx_device *dev, gs_memory_t *mem, void *buffer)
+{
+    gs_free_object(mem, buffer, "png_band_init_buffer");
+}
+
+static void *
+png_band_zalloc(void *mem_, unsigned int items, unsigned int size)
+{
+    return gs_alloc_bytes((gs_memory_t *)mem_, (size_t)items * size,
+                          "png_band_zalloc");
+}
+
+static void
+png_band_zfree(void *mem_, void *address)
+{
+    gs_free_object((gs_memory_t *)mem_, address, "png_band_zfree");
+}
+
+static inline byte
+png_paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+static int
+png_band_process(void *arg_, gx_device *dev, gx_device *bdev,
+                 const gs_int_rect *rect, void *buffer_)
+{
+    png_band_arg_t *arg = (png_band_arg_t *)arg_;
+    png_band_buffer_t *buffer = (png_band_buffer_t *)buffer_;
+    int bpp = arg->bpp;
+    int w = rect->q.x - rect->p.x;
+    int h = rect->q.y - rect->p.y;
+    int row_bytes = w * bpp;
+    gs_get_bits_params_t params;
+    gs_int_rect band_rect;
+    z_stream stream;
+    byte sub = 1, paeth = 4;
+    byte *p;
+    int x, y, err, code;
+    uint raster;
+
+    buffer->compressed = 0;
+    buffer->adler = adler32(0L, NULL, 0);
+    buffer->length = 0;
+    if (w <= 0 || h <= 0)
+        return 0;
+
+    params.options = GB_COLORS_NATIVE | GB_ALPHA_NONE | GB_PACKING_CHUNKY |
+                     GB_RETURN_POINTER | GB_ALIGN_ANY | GB_OFFSET_0 |
+                     GB_RASTER_ANY;
+    band_rect.p.x = 0;
+    band_rect.p.y = 0;
+    band_rect.q.x = w;
+    band_rect.q.y = h;
+    code = dev_proc(bdev, get_bits_rectangle)(bdev, &band_rect, &params);
+    if (code < 0)
+        return code;
+    raster = bitmap_raster(bdev->width * bdev->color_info.depth);
+
+    if (arg->invert_alpha) {
+        for (y = 0, p = params.data[0]; y < h; y++, p += raster)
+            for (x = 3; x < row_bytes; x += 4)
+                p[x] ^= 0xff;
+    }
+
+    /* Filter in place from the bottom up, so that the line above is
+       still unfiltered. */
+    for (y = h - 1; y >= 0; y--) {
+        p = params.data[0] + (size_t)raster * y;
+        if (y > 0) {
+            const byte *up = p - raster;
+
+            for (x = row_bytes - 1; x >= bpp; x--)
+                p[x] -= png_paeth(p[x - bpp], up[x], up[x - bpp]);
+            for (; x >= 0; x--)
+                p[x] -= up[x];
+        } else {
+            for (x = row_bytes - 1; x >= bpp; x--)
+                p[x] -= p[x - bpp];
+        }
+    }
+
+    stream.zalloc = png_band_zalloc;
+    stream.zfree = png_band_zfree;
+    stream.opaque = bdev->memory;
+    err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                       8, Z_FILTERED);
+    if (err != Z_OK)
+        return_error(gs_error_VMerror);
+    stream.next_out = buffer->data + sizeof(png_zlib_header);
+    stream.avail_out = buffer->size - sizeof(png_zlib_header);
+    for (y = 0, p = params.data[0]; y < h && err == Z_OK; y++, p += raster) {
+        byte *filter = (y == 0 ? &sub : &paeth);
+
+        buffer->adler = adler32(buffer->adler, filter, 1);
+        buffer->adler = adler32(buffer->adler, p, row_bytes);
+        stream.next_in = filter;
+        stream.avail_in = 1;
+        err = deflate(&stream, Z_NO_FLUSH);
+        if (err != Z_OK)
+            break;
+        stream.next_in = p;
+        stream.avail_in = row_bytes;
+        err = deflate(&stream, y == h - 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+    }
+    buffer->compressed = stream.total_out;
+    buffer->length = stream.total_in;
+    (void)deflateEnd(&stream);
+    if (err != Z_OK || stream.avail_in != 0)
+        return_error(gs_error_ioerror);
+    return 0;
+}
+
+static int
+png_band_output(void *arg_, gx_device *dev, void *buffer_)
+{
+    png_band_arg_t *arg = (png_band_arg_t *)arg_;
+    png_band_buffer_t *buffer = (png_band_buffer_t *)buffer_;
+    byte *data = buffer->data + sizeof(png_zlib_header);
+    uInt size = buffer->compressed;
+
+    if (arg->first) {
+        data = buffer->data;
+        size += sizeof(png_zlib_header);
+        arg->first = false;
+    }
+    arg->adler = adler32_combine(arg->adler, buffer->adler, buffer->length);
+    if (size > 0)
+        png_write_chunk(arg->png_ptr, (png_bytep)"IDAT", data, size);
+    return 0;
+}
+
+/* Write the image data and the end of the file, one band at a time. */
+static int
+png_write_bands(gx_device_png *pdev, png_struct *png_ptr, int bpp,
+                bool invert_alpha)
+{
+    png_band_arg_t arg;
+    gx_process_page_options_t options = { 0 };
+    /* An empty final block, then room for the Adler-32 */
+    byte tail[6] = { 0x03, 0x00 };
+    int code;
+
+    arg.png_ptr = png_ptr;
+    arg.bpp = bpp;
+    arg.invert_alpha = invert_alpha;
+    arg.first = true;
+    arg.adler = adler32(0L, NULL, 0);
+
+    options.init_buffer_fn = png_band_init_buffer;
+    options.free_buffer_fn = png_band_free_buffer;
+    options.process_fn = png_band_process;
+    options.output_fn = png_band_output;
+    options.arg = &arg;
+    code = dev_proc(pdev, process_page)((gx_device *)pdev, &options);
+    if (code < 0)
+        return code;
+
+    tail[2] = (byte)(arg.adler >> 24);
+    tail[3] = (byte)(arg.adler >> 16);
+    tail[4] = (byte)(arg.adler >> 8);
+    tail[5] = (byte)arg.adler;
+    if (arg.first)
+        png_write_chunk(png_ptr, (png_bytep)"IDAT", png_zlib_header,
+                        sizeof(png_zlib_header));
+    png_write_chunk(png_ptr, (png_bytep)"IDAT", tail, sizeof(tail));
+    /* png_write_end() won't accept IDATs it didn't write itself, and
+       there is nothing else left for it to write. */
+    png_write_chunk(png_ptr, (png_bytep)"IEND", NULL, 0);
+    return 0;
+}
+
 /* Write out a page in PNG format. */
 /* This routine is used for all formats. */
 OPTIMIZE_SETJMP
@@ -797,6 +1036,15 @@ do_png_print_page(gx_device_png * pdev, gp_file * file, bool monod)
     info_ptr->text = NULL;
 #endif
 
+    /* With rendering threads, compress the bands in the threads. This
+     * doesn't do any downscaling, so only when there's none to do. */
+    if (PRINTER_IS_CLIST(pdev) && pdev->num_render_threads_requested > 0 &&
+        bit_depth == 8 && !monod && upfactor == 1 && downfactor == 1 &&
+        (depth == 8 ? color_type == PNG_COLOR_TYPE_GRAY : depth >= 24)) {
+        code = png_write_bands(pdev, png_ptr, depth >> 3, invert);
+        goto written;
+    }
+
     /* For simplicity of code, we always go through the downscaler. For
      * non-supported depths, it will pass through with minimal performance
      * hit. So ensure that we only trigger downscales when we need them.
@@ -828,6 +1076,8 @@ do_png_print_page(gx_device_png * pdev, gp_file * file, bool monod)
     /* write the rest of the file */
     png_write_end(png_ptr, info_ptr);
 
+  written:
+
 #if PNG_LIBPNG_VER_MINOR >= 5
 #else
     /* if you alloced the palette, free it here */
@@ -37,6 +37,7 @@
 #include "gdevpsd.h"
 #include "gxdevsop.h"
 #include "gsicc_cms.h"
+#include "gxsync.h"
 
 #ifndef MAX_CHAN
 #   define MAX_CHAN 15
@@ -1720,6 +1721,135 @@ psd_prn_close(gx_device *dev)
  * SeparationOrder data.
  */
 
+/*
+ * With rendering threads, the channels are converted and written by a
+ * devn_sep_writer, while the main thread gets the next rows. Each channel
+ * collects a few rows before they are written out in one go, so that the
+ * file isn't written one seek and one line at a time. The writes still
+ * share the one file, so they take turns.
+ */
+#define PSD_CHANNEL_BUFFER_SIZE 65536
+
+typedef struct psd_channel_write_s {
+    psd_write_ctx *xc;
+    gx_monitor_t *lock;
+    gs_offset_t image_pos;        /* Where the first channel starts */
+    size_t octets_per_line;
+    int octets_per_component;
+    int buffer_rows;
+    byte *buffer[GS_CLIENT_COLOR_MAX_COMPONENTS];
+    int buffered[GS_CLIENT_COLOR_MAX_COMPONENTS];
+} psd_channel_write_t;
+
+static int
+psd_write_channel_row(void *arg, int chan_idx, byte *row, int y)
+{
+    psd_channel_write_t *cw = (psd_channel_write_t *)arg;
+    psd_write_ctx *xc = cw->xc;
+    size_t octets_per_line = cw->octets_per_line;
+    byte *dest;
+    int i, code = 0;
+
+    if (row == NULL && chan_idx >= NUM_CMYK_COMPONENTS)
+        return 0;       /* Nothing is written for these */
+    dest = cw->buffer[chan_idx] + cw->buffered[chan_idx] * octets_per_line;
+    if (row == NULL) {
+        /* Write empty process color in the area */
+        memset(dest, 255, octets_per_line);
+    } else if (xc->base_num_channels == 3 && chan_idx < 3) {
+        memcpy(dest, row, octets_per_line);
+    } else if (cw->octets_per_component == 1) {
+        for (i = 0; i < xc->width; ++i)
+            dest[i] = 255 - row[i];
+    } else { /* octets_per_component == 2 */
+        for (i = 0; i < xc->width; ++i)
+            ((unsigned short *)dest)[i] = 65535 - ((unsigned short *)row)[i];
+    }
+    if (++cw->buffered[chan_idx] < cw->buffer_rows && y < xc->height-1)
+        return 0;
+
+    gx_monitor_enter(cw->lock);
+    if (gp_fseek(xc->f, cw->image_pos + ((gs_offset_t)chan_idx * xc->height +
+                 y + 1 - cw->buffered[chan_idx]) * octets_per_line, SEEK_SET) < 0)
+        code = gs_note_error(gs_error_ioerror);
+    else if (gp_fwrite(cw->buffer[chan_idx], octets_per_line,
+                       cw->buffered[chan_idx], xc->f) != cw->buffered[chan_idx])
+        code = gs_note_error(gs_error_ioerror);
+    gx_monitor_leave(cw->lock);
+    cw->buffered[chan_idx] = 0;
+    return code;
+}
+
+static int
+psd_write_image_data_threaded(psd_write_ctx *xc, gx_device_printer *pdev,
+                              gx_downscaler_t *ds, gs_get_bits_params_t *params,
+                              int octets_per_component)
+{
+    int num_comp = xc->num_channels;
+    psd_channel_write_t cw;
+    devn_sep_writer_t *writer;
+    byte *src[GS_CLIENT_COLOR_MAX_COMPONENTS];
+    int chan_idx, j, code = 0, code1;
+
+    memset(&cw, 0, sizeof(cw));
+    cw.xc = xc;
+    cw.octets_per_line = (size_t)xc->width * octets_per_component;
+    cw.octets_per_component = octets_per_component;
+    cw.buffer_rows = PSD_CHANNEL_BUFFER_SIZE / cw.octets_per_line;
+    if (cw.buffer_rows < 1)
+        cw.buffer_rows = 1;
+    cw.image_pos = gp_ftell(xc->f);
+    if (cw.image_pos < 0)
+        return_error(gs_error_ioerror);
+    cw.lock = gx_monitor_label(gx_monitor_alloc(pdev->memory), "psd_write_image_data");
+    if (cw.lock == NULL)
+        return_error(gs_error_VMerror);
+    for (chan_idx = 0; chan_idx < num_comp; chan_idx++) {
+        cw.buffer[chan_idx] = gs_alloc_bytes(pdev->memory,
+                                             cw.buffer_rows * cw.octets_per_line,
+                                             "psd_write_image_data_threaded");
+        if (cw.buffer[chan_idx] == NULL) {
+            code = gs_note_error(gs_error_VMerror);
+            goto done;
+        }
+    }
+    writer = devn_sep_writer_start(pdev->memory, num_comp, cw.octets_per_line,
+                                   pdev->num_render_threads_requested,
+                                   psd_write_channel_row, &cw);
+    if (writer == NULL) {
+        code = 1;       /* Let the caller do it */
+        goto done;
+    }
+
+    for (j = 0; j < xc->height; ++j) {
+        code = gx_downscaler_get_bits_rectangle(ds, params, j);
+        if (code < 0)
+            break;
+        for (chan_idx = 0; chan_idx < num_comp; chan_idx++) {
+            int data_pos = xc->chnl_to_position[chan_idx];
+
+            src[chan_idx] = data_pos >= 0 ? params->data[data_pos] : NULL;
+        }
+        code = devn_sep_writer_put(writer, j, src);
+        if (code < 0)
+            break;
+    }
+    code1 = devn_sep_writer_finish(writer);
+    if (code >= 0)
+        code = code1;
+    /* Leave the file where the plane by plane loop would have. */
+    if (code >= 0 && gp_fseek(xc->f, cw.image_pos + (gs_offset_t)num_comp *
+                              xc->height * cw.octets_per_line, SEEK_SET) < 0)
+        code = gs_note_error(gs_error_ioerror);
+
+done:
+    for (chan_idx = 0; chan_idx < num_comp; chan_idx++)
+        gs_free_object(pdev->memory, cw.buffer[chan_idx],
+                       "psd_write_image_data_threaded");
+    gx_monitor_free(cw.lock);
+    return code;
+}
+
 static int
 psd_write_image_data(psd_write_ctx *xc, gx_device_printer *pdev)
 {
@@ -1768,6 +1898,14 @@ psd_write_image_data(psd_write_ctx *xc, gx_device_printer *pdev)
     if (code < 0)
         goto cleanup;
 
+    if (pdev->num_render_threads_requested > 0) {
+        code = psd_write_image_data_threaded(xc, pdev, &ds, &params,
+                                             octets_per_component);
+        if (code <= 0)
+            goto cleanup;
+        code = 0;
+    }
+
     /* Print the output planes */
     for (j = 0; j < xc->height; ++j) {
         code = gx_downscaler_get_bits_rectangle(&ds, &params, j);
@@ -28,6 +28,9 @@
 #include "scommon.h"
 #include "stream.h"
 #include "strmio.h"
+#include "strimpl.h"
+#include "slzwx.h"
+#include "srlx.h"
 #include "gsicc_cache.h"
 #include "gscms.h"
 #include "gstiffio.h"
@@ -438,6 +441,292 @@ int tiff_set_fields_for_printer(gx_device_printer *pdev,
     return 0;
 }
 
+/* ------ Compressing in the rendering threads ------ */
+
+/*
+ * When the page is rendered by several threads, tiff_print_page has the
+ * thread that rendered each band encode the band's rows itself. The main
+ * thread then only has to write the data out in order, with
+ * TIFFWriteRawStrip. This is done for the compressions that our own
+ * stream filters can produce: LZW and PackBits (and none).
+ *
+ * The strips are still RowsPerStrip high, as set from MaxStripSize. With
+ * no compression or PackBits each row is encoded on its own, so a strip
+ * can be written in pieces from two or more bands. An LZW strip has to be
+ * encoded in one go, so for LZW each band must hold a whole number of
+ * strips, otherwise the page is written a row at a time as usual.
+ */
+
+typedef struct tiff_band_arg_s {
+    TIFF *tif;
+    uint16_t compression;
+    bool reverse_bits;		/* FillOrder is LSB2MSB */
+    int bpc;
+    size_t row_size;
+    int rows_per_strip;
+    int height;
+    int band_height;
+    int row;			/* next row to write */
+} tiff_band_arg_t;
+
+/* Each band is encoded as one or more pieces, split where strips start */
+typedef struct tiff_band_buffer_s {
+    size_t size;
+    int y;			/* the band's first row */
+    int rows;
+    int num_pieces;
+    size_t *lengths;		/* of the encoded pieces */
+    byte data[1];
+} tiff_band_buffer_t;
+
+static bool
+tiff_band_compression_ok(uint16_t compression)
+{
+    return compression == COMPRESSION_NONE || compression == COMPRESSION_LZW ||
+           compression == COMPRESSION_PACKBITS;
+}
+
+static int
+tiff_band_max_pieces(const tiff_band_arg_t *arg)
+{
+    return arg->band_height / arg->rows_per_strip + 2;
+}
+
+static int
+tiff_band_init_buffer(void *arg_, gx_device *dev, gs_memory_t *mem, int w, int h,
+                      void **pbuffer)
+{
+    tiff_band_arg_t *arg = (tiff_band_arg_t *)arg_;
+    tiff_band_buffer_t *buffer;
+    int max_pieces = tiff_band_max_pieces(arg);
+    size_t n = arg->row_size * h;
+    /* LZW is at most 12 bits for each byte, PackBits 1 byte in 128 (plus
+       one for each row). Each piece may need a few more for LZW. */
+    size_t size = n + n / 2 + (arg->row_size / 128 + 2) * h + 64 * max_pieces;
+
+    buffer = (tiff_band_buffer_t *)gs_alloc_bytes(mem, sizeof(*buffer) +
+                                                  ROUND_UP(size, sizeof(size_t)) +
+                                                  max_pieces * sizeof(size_t),
+                                                  "tiff_band_init_buffer");
+    *pbuffer = buffer;
+    if (buffer == NULL)
+        return_error(gs_error_VMerror);
+    buffer->size = size;
+    buffer->y = 0;
+    buffer->rows = 0;
+    buffer->num_pieces = 0;
+    buffer->lengths = (size_t *)(buffer->data + ROUND_UP(size, sizeof(size_t)));
+    return 0;
+}
+
+static void
+tiff_band_free_buffer(void *arg, gx_device *dev, gs_memory_t *mem, void *buffer)
+{
+    gs_free_object(mem, buffer, "tiff_band_init_buffer");
+}
+
+/* Encode rows [y0, y1) of the band into the buffer, as one piece */
+static int
+tiff_band_encode_piece(tiff_band_arg_t *arg, gx_device *bdev, byte *rows, uint raster,
+                       int y0, int y1, stream_cursor_write *w, size_t *length)
+{
+    union {
+        stream_LZW_state lzw;
+        stream_RLE_state rle;
+    } state;
+    stream_state *st = NULL;
+    stream_cursor_read r;
+    byte *start = w->ptr + 1;
+    int y, status = 0;
+
+    if (arg->compression == COMPRESSION_LZW) {
+        st = (stream_state *)&state.lzw;
+        s_init_state(st, &s_LZWE_template, bdev->memory);
+        s_LZWE_template.set_defaults(st);
+    } else if (arg->compression == COMPRESSION_PACKBITS) {
+        st = (stream_state *)&state.rle;
+        s_init_state(st, &s_RLE_template, bdev->memory);
+        s_RLE_template.set_defaults(st);
+        /* PackBits runs stop at the end of each row, and there's no EOD */
+        state.rle.record_size = arg->row_size;
+        state.rle.omitEOD = true;
+    }
+    if (st != NULL && st->templat->init(st) < 0)
+        return_error(gs_error_VMerror);
+
+    for (y = y0; y < y1; y++) {
+        byte *row = rows + (size_t)raster * y;
+
+#if defined(ARCH_IS_BIG_ENDIAN) && (!ARCH_IS_BIG_ENDIAN)
+        if (arg->bpc == 16)
+            TIFFSwabArrayOfShort((uint16_t *)row, arg->row_size >> 1);
+#endif
+        if (st == NULL) {
+            memcpy(w->ptr + 1, row, arg->row_size);
+            w->ptr += arg->row_size;
+            continue;
+        }
+        r.ptr = row - 1;
+        r.limit = row + arg->row_size - 1;
+        status = st->templat->process(st, &r, w, y == y1 - 1);
+        /* The buffer is big enough for the worst case, so the filter
+           should always take all of the row. */
+        if ((status < 0 && status != EOFC) || status == 1 || r.ptr != r.limit)
+            break;
+    }
+    if (st != NULL && st->templat->release != NULL)
+        st->templat->release(st);
+    if (y < y1)
+        return_error(gs_error_ioerror);
+    *length = w->ptr + 1 - start;
+    /* TIFFWriteEncodedStrip does this for us, TIFFWriteRawStrip doesn't */
+    if (arg->reverse_bits)
+        TIFFReverseBits(start, *length);
+    return 0;
+}
+
+static int
+tiff_band_process(void *arg_, gx_device *dev, gx_device *bdev,
+                  const gs_int_rect *rect, void *buffer_)
+{
+    tiff_band_arg_t *arg = (tiff_band_arg_t *)arg_;
+    tiff_band_buffer_t *buffer = (tiff_band_buffer_t *)buffer_;
+    int h = rect->q.y - rect->p.y;
+    gs_get_bits_params_t params;
+    gs_int_rect band_rect;
+    stream_cursor_write w;
+    uint raster;
+    int y, y1, code;
+
+    buffer->y = rect->p.y;
+    buffer->rows = h;
+    buffer->num_pieces = 0;
+    if (h <= 0)
+        return 0;
+
+    params.options = GB_COLORS_NATIVE | GB_ALPHA_NONE | GB_PACKING_CHUNKY |
+                     GB_RETURN_POINTER | GB_ALIGN_ANY | GB_OFFSET_0 |
+                     GB_RASTER_ANY;
+    band_rect.p.x = 0;
+    band_rect.p.y = 0;
+    band_rect.q.x = rect->q.x - rect->p.x;
+    band_rect.q.y = h;
+    code = dev_proc(bdev, get_bits_rectangle)(bdev, &band_rect, &params);
+    if (code < 0)
+        return code;
+    raster = bitmap_raster(bdev->width * bdev->color_info.depth);
+
+    w.ptr = buffer->data - 1;
+    w.limit = buffer->data + buffer->size - 1;
+    for (y = 0; y < h; y = y1) {
+        /* Up to the start of the next strip */
+        y1 = (rect->p.y + y) / arg->rows_per_strip * arg->rows_per_strip +
+             arg->rows_per_strip - rect->p.y;
+        if (y1 > h)
+            y1 = h;
+        if (buffer->num_pieces == tiff_band_max_pieces(arg))
+            return_error(gs_error_rangecheck);
+        code = tiff_band_encode_piece(arg, bdev, params.data[0], raster, y, y1, &w,
+                                      &buffer->lengths[buffer->num_pieces]);
+        if (code < 0)
+            return code;
+        buffer->num_pieces++;
+    }
+    return 0;
+}
+
+static int
+tiff_band_output(void *arg_, gx_device *dev, void *buffer_)
+{
+    tiff_band_arg_t *arg = (tiff_band_arg_t *)arg_;
+    tiff_band_buffer_t *buffer = (tiff_band_buffer_t *)buffer_;
+    byte *data = buffer->data;
+    int i, row = arg->row;
+
+    if (buffer->y != arg->row)
+        return_error(gs_error_rangecheck);
+    for (i = 0; i < buffer->num_pieces; i++) {
+        /* Consecutive writes to the same strip are appended */
+        if (TIFFWriteRawStrip(arg->tif, row / arg->rows_per_strip, data,
+                              buffer->lengths[i]) < 0)
+            return_error(gs_error_ioerror);
+        data += buffer->lengths[i];
+        row = (row / arg->rows_per_strip + 1) * arg->rows_per_strip;
+    }
+    arg->row += buffer->rows;
+    return 0;
+}
+
+/* Can tiff_print_page do this page a band at a time? */
+static bool
+tiff_print_page_by_band(gx_device_printer *dev, TIFF *tif, int min_feature_size)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    uint16_t compression;
+    uint32_t rows_per_strip;
+
+    if (!PRINTER_IS_CLIST(dev) || dev->num_render_threads_requested < 1 ||
+        min_feature_size > 1)
+        return false;
+    if (!TIFFGetField(tif, TIFFTAG_COMPRESSION, &compression))
+        compression = COMPRESSION_NONE;
+    if (!tiff_band_compression_ok(compression))
+        return false;
+    /* The fax devices can write a different width from the device's */
+    if (TIFFScanlineSize(tif) > gdev_mem_bytes_per_scan_line((gx_device *)dev))
+        return false;
+    if (!TIFFGetField(tif, TIFFTAG_ROWSPERSTRIP, &rows_per_strip) ||
+        rows_per_strip == 0)
+        return false;
+    if (rows_per_strip > dev->height)
+        rows_per_strip = dev->height;
+    /* An LZW strip can't be split between bands */
+    if (compression == COMPRESSION_LZW &&
+        cdev->page_info.band_params.BandHeight < dev->height &&
+        cdev->page_info.band_params.BandHeight % rows_per_strip != 0)
+        return false;
+    return true;
+}
+
+static int
+tiff_print_page_in_bands(gx_device_printer *dev, TIFF *tif)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    tiff_band_arg_t arg;
+    gx_process_page_options_t options = { 0 };
+    uint32_t rows_per_strip;
+    uint16_t fill_order;
+    int code;
+
+    arg.tif = tif;
+    if (!TIFFGetField(tif, TIFFTAG_COMPRESSION, &arg.compression))
+        arg.compression = COMPRESSION_NONE;
+    if (!TIFFGetField(tif, TIFFTAG_FILLORDER, &fill_order))
+        fill_order = FILLORDER_MSB2LSB;
+    arg.reverse_bits = fill_order != FILLORDER_MSB2LSB;
+    arg.bpc = dev->color_info.depth / dev->color_info.num_components;
+    arg.row_size = TIFFScanlineSize(tif);
+    TIFFGetField(tif, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+    arg.rows_per_strip = rows_per_strip > dev->height ? dev->height : rows_per_strip;
+    arg.height = dev->height;
+    arg.band_height = cdev->page_info.band_params.BandHeight;
+    arg.row = 0;
+
+    code = TIFFCheckpointDirectory(tif);
+    if (code < 0)
+        return code;
+
+    options.init_buffer_fn = tiff_band_init_buffer;
+    options.free_buffer_fn = tiff_band_free_buffer;
+    options.process_fn = tiff_band_process;
+    options.output_fn = tiff_band_output;
+    options.arg = &arg;
+    code = dev_proc(dev, process_page)((gx_device *)dev, &options);
+    if (code >= 0)
+        code = TIFFWriteDirectory(tif);
+    return code;
+}
+
 int
 tiff_print_page(gx_device_printer *dev, TIFF *tif, int min_feature_size)
 {
@@ -451,11 +740,14 @@ tiff_print_page(gx_device_printer *dev, TIFF *tif, int min_feature_size)
     int line_lag = 0;
     int filtered_count;
 
+    if (bpc != 1)
+        min_feature_size = 1;
+    if (tiff_print_page_by_band(dev, tif, min_feature_size))
+        return tiff_print_page_in_bands(dev, tif);
+
     data = gs_alloc_bytes(dev->memory, max_size, "tiff_print_page(data)");
     if (data == NULL)
         return_error(gs_error_VMerror);
-    if (bpc != 1)
-        min_feature_size = 1;
     if (min_feature_size > 1) {
         code = min_feature_size_init(dev->memory, min_feature_size,
                                      dev->width, dev->height,
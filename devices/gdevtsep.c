@@ -2061,6 +2061,30 @@ print_cmyk_equivalent_colors(tiffsep_device *tfdev, int num_comp, cmyk_composite
  * The DeviceN parameters (SeparationOrder, SeparationColorNames, and
  * MaxSeparations) are applied to the tiffsep device.
  */
+/*
+ * With rendering threads, the separation files are written by a
+ * devn_sep_writer, so that they are compressed (and written) at the same
+ * time, while the main thread gets on with the next rows and the CMYK
+ * composite.
+ */
+typedef struct tiffsep_sep_write_s {
+    tiffsep_device *tfdev;
+    int byte_width;
+} tiffsep_sep_write_t;
+
+static int
+tiffsep_write_sep_row(void *arg, int comp_num, byte *row, int y)
+{
+    tiffsep_sep_write_t *sw = (tiffsep_sep_write_t *)arg;
+    int pixel;
+
+    for (pixel = 0; pixel < sw->byte_width; pixel++)
+        row[pixel] = MAX_COLOR_VALUE - row[pixel];    /* Gray is additive */
+    if (TIFFWriteScanline(sw->tfdev->tiff[comp_num], (tdata_t)row, y, 0) < 0)
+        return_error(gs_error_ioerror);
+    return 0;
+}
+
 static int
 tiffsep_print_page(gx_device_printer * pdev, gp_file * file)
 {
@@ -2245,6 +2269,8 @@ tiffsep_print_page(gx_device_printer * pdev, gp_file * file)
         {
             gs_get_bits_params_t params;
             int byte_width;
+            devn_sep_writer_t *sep_writer = NULL;
+            tiffsep_sep_write_t sep_write;
 
             /* Return planar data */
             params.options = (GB_RETURN_POINTER | GB_RETURN_COPY |
@@ -2323,12 +2349,28 @@ tiffsep_print_page(gx_device_printer * pdev, gp_file * file)
             if (code < 0)
                 goto cleanup;
             byte_width = (width * dst_bpc + 7)>>3;
+            if (!tfdev->NoSeparationFiles && pdev->num_render_threads_requested > 0) {
+                sep_write.tfdev = tfdev;
+                sep_write.byte_width = byte_width;
+                sep_writer = devn_sep_writer_start(pdev->memory, num_comp, byte_width,
+                                                   pdev->num_render_threads_requested,
+                                                   tiffsep_write_sep_row, &sep_write);
+            }
             for (y = 0; y < height; ++y) {
                 code = gx_downscaler_get_bits_rectangle(&ds, &params, y);
                 if (code < 0)
                     goto cleanup;
                 /* Write separation data (tiffgray format) */
-                if (!tfdev->NoSeparationFiles) {
+                if (sep_writer != NULL) {
+                    byte *src[GS_CLIENT_COLOR_MAX_COMPONENTS];
+
+                    for (comp_num = 0; comp_num < num_comp; comp_num++)
+                        src[comp_num] = params.data[num_order > 0 ?
+                            tfdev->devn_params.separation_order_map[comp_num] : comp_num];
+                    code = devn_sep_writer_put(sep_writer, y, src);
+                    if (code < 0)
+                        goto cleanup;
+                } else if (!tfdev->NoSeparationFiles) {
                     for (comp_num = 0; comp_num < num_comp; comp_num++) {
                         byte *src;
                         byte *dest = sep_line;
@@ -2371,6 +2413,12 @@ tiffsep_print_page(gx_device_printer * pdev, gp_file * file)
                 TIFFWriteScanline(tfdev->tiff_comp, (tdata_t)sep_line, y, 0);
             }
 cleanup:
+            if (sep_writer != NULL) {
+                int code2 = devn_sep_writer_finish(sep_writer);
+
+                if (code >= 0)
+                    code = code2;
+            }
             if (num_order > 0) {
                 /* Free up the standard colorants if num_order was set.
                    In this process, we need to make sure that none of them